@@ -51,7 +51,7 @@ void BitByBitData::setPosition(const BitPosition& bp)
   }
 }
 
-void BitByBitData::setPosition(unsigned int byte, unsigned int bit)
+void BitByBitData::setPosition(uint64_t byte, unsigned int bit)
 {
   if(byte <= length)
   {
@@ -81,6 +81,13 @@ void BitByBitData::tellPosition()
 
 bool BitByBitData::readBit()
 {
+  // data reaches the end after the last bit, which may be the end of a
+  // mapping, so it is checked before each read
+  if(!failed && data == start+length)
+  {
+    failed = true;
+    cerr << "End of data."<< endl;
+  }
   if(!failed)
   {
     bool val = *data & bitMask;
@@ -153,6 +160,21 @@ int BitByBitData::readInt()
 
 // Thanks to Michail Vidiassov
 double BitByBitData::readDouble()
+{
+  DoubleEncoding encoding;
+  if(doubleProfile == NULL)
+    return decodeDouble(encoding);
+
+  BitPosition before = getPosition();
+  double value = decodeDouble(encoding);
+  BitPosition after = getPosition();
+  ++doubleProfile->count[encoding];
+  doubleProfile->bits[encoding] += 8*(after.byteIndex-before.byteIndex)
+      + after.bitIndex - before.bitIndex;
+  return value;
+}
+
+double BitByBitData::decodeDouble(DoubleEncoding &encoding)
 {
   ieee754_double value;
   value.d = 0;
@@ -166,6 +188,7 @@ double BitByBitData::readDouble()
       break;
   }
   value.d = pcofdoe->u2uod.Value;
+  encoding = FREQUENT_DOUBLE;
 
   // check if zero
   if(pcofdoe->NumberOfBits==2 && pcofdoe->Bits==1 && pcofdoe->Type==VT_double)
@@ -176,8 +199,10 @@ double BitByBitData::readDouble()
   if(pcofdoe->Type == VT_double) // double from list
     return value.d;
 
+  encoding = EXPONENT_ONLY_DOUBLE;
   if(readBit()==0) // no mantissa
     return value.d;
+  encoding = MANTISSA_DOUBLE;
 
   // read the mantissa
   // read uppermost 4 bits of mantissa
@@ -246,13 +271,7 @@ void BitByBitData::nextBit()
   bitMask >>= 1;
   if(bitMask == 0)
   {
-    if(data < start+length)
-      data++;
-    else
-    {
-      failed = true;
-      cout << "End of data."<< endl;
-    }
+    data++;
     bitMask = 0x80;
   }
 }
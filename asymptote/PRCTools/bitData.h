@@ -23,24 +23,47 @@
 
 #include <iostream>
 #include <string>
+#include <stdint.h>
 
 struct BitPosition
 {
-  unsigned int byteIndex;
+  uint64_t byteIndex;
   unsigned int bitIndex;
 };
 
+// How readDouble() found a double encoded: as one of the frequent values
+// (including zero), as an exponent without mantissa, or with a mantissa.
+enum DoubleEncoding { FREQUENT_DOUBLE, EXPONENT_ONLY_DOUBLE, MANTISSA_DOUBLE,
+                      NUMBER_OF_DOUBLE_ENCODINGS };
+
+struct DoubleProfile
+{
+  DoubleProfile() { clear(); }
+  void clear()
+  {
+    for(unsigned int i = 0; i < NUMBER_OF_DOUBLE_ENCODINGS; ++i)
+      count[i] = bits[i] = 0;
+  }
+  uint64_t count[NUMBER_OF_DOUBLE_ENCODINGS];
+  uint64_t bits[NUMBER_OF_DOUBLE_ENCODINGS];
+};
+
 class BitByBitData
 {
   public:
-    BitByBitData(char* s,unsigned int l) : start(s),data(s),length(l),
-                 bitMask(0x80),showBits(false),failed(false) {}
+    BitByBitData(char* s,uint64_t l) : start(s),data(s),length(l),
+                 bitMask(0x80),showBits(false),failed(l == 0),
+                 doubleProfile(NULL) {}
 
     void tellPosition();
     BitPosition getPosition();
     void setPosition(const BitPosition&);
-    void setPosition(unsigned int,unsigned int);
+    void setPosition(uint64_t,unsigned int);
     void setShowBits(bool);
+    // add the encoding and size of every double read to profile, NULL to
+    // stop
+    void setDoubleProfile(DoubleProfile *profile) { doubleProfile = profile; }
+    bool readFailed() const { return failed; } // ran past the end?
     bool readBit();
     unsigned char readChar();
 
@@ -52,11 +75,13 @@ class BitByBitData
   private:
     char *start;  // first byte so we know where we are
     char *data;    // last byte read
-    unsigned int length;
+    uint64_t length;
     unsigned char bitMask;  // mask to read next bit of current byte
     bool showBits; // show each bit read?
     bool failed;
+    DoubleProfile *doubleProfile;
     void nextBit(); // shift bit mask and get next byte if needed
+    double decodeDouble(DoubleEncoding&);
 };
 
 #endif // __BITDATA_H
@@ -0,0 +1,913 @@
+/************
+*
+*   This file is part of a tool for reading 3D content in the PRC format.
+*   Copyright (C) 2008 Orest Shardt <shardtor (at) gmail dot com>
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU Lesser General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU Lesser General Public License for more details.
+*
+*   You should have received a copy of the GNU Lesser General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*************/
+
+#include <algorithm>
+#include <cmath>
+#include "describeEmitter.h"
+
+using std::string; using std::vector; using std::ofstream; using std::ios;
+
+void DescribeEmitter::flush()
+{
+  out.flush();
+}
+
+// text
+
+DescribeEmitter* TextEmitter::createPart(OutputSink &o, const string&) const
+{
+  return new TextEmitter(o);
+}
+
+OutputSink& TextEmitter::line()
+{
+  if(indentation.size() != 2*depth)
+    indentation.assign(2*depth,' ');
+  return out << indentation;
+}
+
+OutputSink& TextEmitter::tabbedLine()
+{
+  for(unsigned int i = 0; i < depth; ++i)
+    out << '\t';
+  return out;
+}
+
+void TextEmitter::writeUnit(const char *unit)
+{
+  if(unit != NULL)
+    out << unit;
+  out << '\n';
+}
+
+void TextEmitter::beginFile(const string &path)
+{
+  line() << "Input file " << path << '\n';
+}
+
+void TextEmitter::endFile(const string &path, const char *error)
+{
+  if(error)
+    line() << "Error in " << path << ": " << error << '\n';
+  else
+    line() << "Done with " << path << '\n';
+}
+
+void TextEmitter::fileStructure(unsigned int index)
+{
+  line() << "File Structure " << index << ":\n";
+}
+
+void TextEmitter::entity(const char *type)
+{
+  line() << "--" << type << "--\n";
+}
+
+void TextEmitter::sectionCode(unsigned int found, unsigned int expected)
+{
+  if(found == expected)
+    line() << "Section code " << expected << '\n';
+  else
+  {
+    line() << "Invalid section code " << found << ". Expected " << expected
+        << " at ";
+    position();
+  }
+}
+
+void TextEmitter::field(const char *label, int value, const char *unit)
+{
+  line() << label << value;
+  writeUnit(unit);
+}
+
+void TextEmitter::field(const char *label, unsigned int value,
+                        const char *unit)
+{
+  line() << label << value;
+  writeUnit(unit);
+}
+
+void TextEmitter::field(const char *label, double value, const char *unit)
+{
+  line() << label << value;
+  writeUnit(unit);
+}
+
+void TextEmitter::flag(const char *label, bool value)
+{
+  line() << label << (value?"yes":"no") << '\n';
+}
+
+void TextEmitter::unindentedFlag(const char *label, bool value)
+{
+  out << label << (value?"yes":"no") << '\n';
+}
+
+void TextEmitter::text(const char *label, const string &value, bool quoted)
+{
+  if(quoted)
+    line() << label << '\"' << value << "\"\n";
+  else
+    line() << label << value << '\n';
+}
+
+void TextEmitter::coordinates(const char *label, const double *values,
+                              unsigned int count)
+{
+  line() << label << '(';
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    if(i != 0)
+      out << ',';
+    out << values[i];
+  }
+  out << ")\n";
+}
+
+void TextEmitter::colour(double r, double g, double b)
+{
+  line() << "R: " << r << " G: " << g << " B: " << b << '\n';
+}
+
+void TextEmitter::row(const unsigned int *values, unsigned int count)
+{
+  line();
+  for(unsigned int i = 0; i < count; ++i)
+    out << values[i] << (i+1 < count ? ' ' : '\n');
+}
+
+void TextEmitter::uuid(const char *label, const unsigned int id[4])
+{
+  line() << label;
+  for(int i = 0; i < 4; ++i)
+    out.writeHex(id[i],8) << ' ';
+  out << '\n';
+}
+
+void TextEmitter::fileHeaderField(const char *label, unsigned int value)
+{
+  tabbedLine() << label << value << '\n';
+}
+
+void TextEmitter::fileHeaderUUID(const char *label, const unsigned int id[4])
+{
+  tabbedLine() << label;
+  for(int i = 0; i < 4; ++i)
+  {
+    // as std::ostream writes a void*
+    if(id[i] != 0)
+      out << "0x";
+    out.writeHex(id[i]) << (i < 3 ? " " : "\n");
+  }
+}
+
+void TextEmitter::structureHeaderUUID(const char *label,
+                                      const unsigned int id[4])
+{
+  line() << label;
+  for(int i = 0; i < 4; ++i)
+    out.writeHex(id[i]) << (i < 3 ? " " : "\n");
+}
+
+void TextEmitter::userData(const string &bits)
+{
+  line() << static_cast<unsigned int>(bits.size()) << " bits of user data\n";
+  indent();
+  for(size_t i = 0; i < bits.size(); i += 64)
+  {
+    line().write(bits.data()+i,std::min<size_t>(64,bits.size()-i));
+    out << '\n';
+  }
+  dedent();
+}
+
+void TextEmitter::array(const char*, const vector<double> &values)
+{
+  indent();
+  for(size_t i = 0; i < values.size(); ++i)
+    line() << values[i] << '\n';
+  dedent();
+}
+
+void TextEmitter::array(const char*, const vector<unsigned int> &values)
+{
+  indent();
+  for(size_t i = 0; i < values.size(); ++i)
+    line() << values[i] << '\n';
+  dedent();
+}
+
+void TextEmitter::note(const char *message)
+{
+  line() << message << '\n';
+}
+
+void TextEmitter::warning(const char *message)
+{
+  out << message << '\n';
+}
+
+void TextEmitter::position()
+{
+  if(source == NULL)
+  {
+    out << '\n';
+    return;
+  }
+  BitPosition bp = source->getPosition();
+  out << bp.byteIndex << ':' << bp.bitIndex << '\n';
+}
+
+void TextEmitter::blankLine()
+{
+  out << '\n';
+}
+
+void TextEmitter::beginBitDump()
+{
+}
+
+void TextEmitter::dumpBit(bool bit)
+{
+  out << bit;
+}
+
+void TextEmitter::endBitDump()
+{
+  out << '\n';
+}
+
+// JSON
+
+JSONEmitter::JSONEmitter(OutputSink &o, const string &sideFilePrefix,
+                         size_t sideFileThreshold) : DescribeEmitter(o),
+    prefix(sideFilePrefix),threshold(sideFileThreshold),doublesOffset(0),
+    integersOffset(0)
+{
+}
+
+DescribeEmitter* JSONEmitter::createPart(OutputSink &o,
+                                         const string &name) const
+{
+  return new JSONEmitter(o,prefix.empty() ? prefix : prefix+'-'+name,
+                         threshold);
+}
+
+void JSONEmitter::writeString(const char *s, size_t length)
+{
+  static const char hexDigits[] = "0123456789abcdef";
+  out << '\"';
+  const char *run = s;
+  for(const char *c = s; c != s+length; ++c)
+  {
+    unsigned char u = static_cast<unsigned char>(*c);
+    if(u >= 0x20 && u != '\"' && u != '\\')
+      continue;
+    out.write(run,c-run);
+    run = c+1;
+    switch(u)
+    {
+      case '\"': out << "\\\""; break;
+      case '\\': out << "\\\\"; break;
+      case '\n': out << "\\n"; break;
+      case '\r': out << "\\r"; break;
+      case '\t': out << "\\t"; break;
+      default:
+        out << "\\u00" << hexDigits[u >> 4] << hexDigits[u & 0xf];
+    }
+  }
+  out.write(run,s+length-run);
+  out << '\"';
+}
+
+void JSONEmitter::writeDouble(double value)
+{
+  // JSON has no representation for infinity and NaN
+  if(std::isfinite(value))
+    out.writeExact(value);
+  else
+    out << "null";
+}
+
+void JSONEmitter::begin(const char *event)
+{
+  out << "{\"event\":\"" << event << "\",\"depth\":" << depth;
+  if(source != NULL)
+  {
+    BitPosition bp = source->getPosition();
+    out << ",\"bit\":" << (bp.byteIndex*8+bp.bitIndex);
+  }
+}
+
+void JSONEmitter::name(const char *label)
+{
+  // "Unit is " -> "Unit is", "ambient colour index: " -> "ambient colour index"
+  size_t length = strlen(label);
+  while(length > 0 && strchr(" :=",label[length-1]) != NULL)
+    --length;
+  out << ",\"name\":";
+  writeString(label,length);
+}
+
+void JSONEmitter::writeUnit(const char *unit)
+{
+  if(unit == NULL)
+    return;
+  while(*unit == ' ')
+    ++unit;
+  out << ",\"unit\":";
+  writeString(unit,strlen(unit));
+}
+
+void JSONEmitter::beginFile(const string &path)
+{
+  begin("begin_file");
+  out << ",\"path\":";
+  writeString(path);
+  end();
+}
+
+void JSONEmitter::endFile(const string &path, const char *error)
+{
+  begin("end_file");
+  out << ",\"path\":";
+  writeString(path);
+  out << ",\"status\":" << (error ? "\"error\"" : "\"ok\"");
+  if(error)
+  {
+    out << ",\"error\":";
+    writeString(error,strlen(error));
+  }
+  end();
+}
+
+void JSONEmitter::fileStructure(unsigned int index)
+{
+  begin("file_structure");
+  out << ",\"index\":" << index;
+  end();
+}
+
+void JSONEmitter::entity(const char *type)
+{
+  begin("entity");
+  out << ",\"type\":";
+  writeString(type,strlen(type));
+  end();
+}
+
+void JSONEmitter::sectionCode(unsigned int found, unsigned int expected)
+{
+  begin("section_code");
+  out << ",\"value\":" << found << ",\"expected\":" << expected
+      << ",\"valid\":" << (found == expected ? "true" : "false");
+  end();
+}
+
+void JSONEmitter::field(const char *label, int value, const char *unit)
+{
+  begin("field");
+  name(label);
+  out << ",\"value\":" << value;
+  writeUnit(unit);
+  end();
+}
+
+void JSONEmitter::field(const char *label, unsigned int value,
+                        const char *unit)
+{
+  begin("field");
+  name(label);
+  out << ",\"value\":" << value;
+  writeUnit(unit);
+  end();
+}
+
+void JSONEmitter::field(const char *label, double value, const char *unit)
+{
+  begin("field");
+  name(label);
+  out << ",\"value\":";
+  writeDouble(value);
+  writeUnit(unit);
+  end();
+}
+
+void JSONEmitter::flag(const char *label, bool value)
+{
+  begin("field");
+  name(label);
+  out << ",\"value\":" << (value ? "true" : "false");
+  end();
+}
+
+void JSONEmitter::text(const char *label, const string &value, bool)
+{
+  begin("field");
+  name(label);
+  out << ",\"value\":";
+  writeString(value);
+  end();
+}
+
+void JSONEmitter::coordinates(const char *label, const double *values,
+                              unsigned int count)
+{
+  begin("vector");
+  name(label);
+  out << ",\"values\":[";
+  for(unsigned int i = 0; i < count; ++i)
+  {
+    if(i != 0)
+      out << ',';
+    writeDouble(values[i]);
+  }
+  out << ']';
+  end();
+}
+
+void JSONEmitter::colour(double r, double g, double b)
+{
+  double rgb[3] = { r, g, b };
+  coordinates("RGB",rgb,3);
+}
+
+void JSONEmitter::row(const unsigned int *values, unsigned int count)
+{
+  begin("row");
+  out << ",\"values\":[";
+  for(unsigned int i = 0; i < count; ++i)
+    out << values[i] << (i+1 < count ? "," : "]");
+  end();
+}
+
+void JSONEmitter::uuid(const char *label, const unsigned int id[4])
+{
+  begin("uuid");
+  name(label);
+  out << ",\"value\":\"";
+  for(int i = 0; i < 4; ++i)
+    out.writeHex(id[i],8);
+  out << '\"';
+  end();
+}
+
+void JSONEmitter::userData(const string &bits)
+{
+  begin("user_data");
+  out << ",\"bits\":";
+  writeString(bits);
+  end();
+}
+
+bool JSONEmitter::openSideFile(ofstream &file, const char *extension)
+{
+  if(prefix.empty())
+    return false;
+  if(!file.is_open())
+    file.open((prefix+extension).c_str(),ios::out|ios::binary|ios::trunc);
+  return file.good();
+}
+
+void JSONEmitter::array(const char *label, const vector<double> &values)
+{
+  begin("array");
+  name(label);
+  out << ",\"type\":\"f64\",\"count\":"
+      << static_cast<unsigned long long>(values.size());
+  if(values.size() >= threshold && openSideFile(doubles,".f64"))
+  {
+    out << ",\"file\":";
+    writeString(prefix+".f64");
+    out << ",\"offset\":" << static_cast<unsigned long long>(doublesOffset);
+    doubles.write(reinterpret_cast<const char*>(&values[0]),
+                  values.size()*sizeof(double));
+    doublesOffset += values.size()*sizeof(double);
+  }
+  else
+  {
+    out << ",\"values\":[";
+    for(size_t i = 0; i < values.size(); ++i)
+    {
+      if(i != 0)
+        out << ',';
+      writeDouble(values[i]);
+    }
+    out << ']';
+  }
+  end();
+}
+
+void JSONEmitter::array(const char *label, const vector<unsigned int> &values)
+{
+  begin("array");
+  name(label);
+  out << ",\"type\":\"u32\",\"count\":"
+      << static_cast<unsigned long long>(values.size());
+  if(values.size() >= threshold && openSideFile(integers,".u32"))
+  {
+    out << ",\"file\":";
+    writeString(prefix+".u32");
+    out << ",\"offset\":" << static_cast<unsigned long long>(integersOffset);
+    integers.write(reinterpret_cast<const char*>(&values[0]),
+                   values.size()*sizeof(unsigned int));
+    integersOffset += values.size()*sizeof(unsigned int);
+  }
+  else
+  {
+    out << ",\"values\":[";
+    for(size_t i = 0; i < values.size(); ++i)
+    {
+      if(i != 0)
+        out << ',';
+      out << values[i];
+    }
+    out << ']';
+  }
+  end();
+}
+
+void JSONEmitter::note(const char *message)
+{
+  begin("note");
+  out << ",\"message\":";
+  writeString(message,strlen(message));
+  end();
+}
+
+void JSONEmitter::warning(const char *message)
+{
+  begin("warning");
+  out << ",\"message\":";
+  writeString(message,strlen(message));
+  end();
+}
+
+void JSONEmitter::position()
+{
+  // every event already carries the position
+}
+
+void JSONEmitter::blankLine()
+{
+}
+
+void JSONEmitter::beginBitDump()
+{
+  dumpedBits.clear();
+}
+
+void JSONEmitter::dumpBit(bool bit)
+{
+  dumpedBits += bit ? '1' : '0';
+}
+
+void JSONEmitter::endBitDump()
+{
+  begin("skipped_bits");
+  out << ",\"bits\":";
+  writeString(dumpedBits);
+  end();
+  dumpedBits.clear();
+}
+
+void JSONEmitter::flush()
+{
+  DescribeEmitter::flush();
+  if(doubles.is_open())
+    doubles.flush();
+  if(integers.is_open())
+    integers.flush();
+}
+
+// statistics
+
+static const char *statisticsSectionNames[] =
+    { "Header", "Globals", "Tree", "Tessellation", "Geometry",
+      "ExtraGeometry", "ModelFile" };
+
+StatisticsEmitter::StatisticsEmitter(OutputSink &o) : DescribeEmitter(o),
+    tallies(new Tallies),section(HEADER),whole(true)
+{
+}
+
+StatisticsEmitter::StatisticsEmitter(OutputSink &o,
+    const std::shared_ptr<Tallies> &t, unsigned int s) : DescribeEmitter(o),
+    tallies(t),section(s),whole(false)
+{
+}
+
+// Part names are "Structure<i>-<section>" or "ModelFile"; the counts of
+// a section are added up over all file structures.
+DescribeEmitter* StatisticsEmitter::createPart(OutputSink &o,
+                                               const string &name) const
+{
+  string sectionName = name.substr(name.find('-')+1);
+  unsigned int s = HEADER;
+  for(unsigned int i = 0; i < NUMBER_OF_SECTIONS; ++i)
+    if(sectionName == statisticsSectionNames[i])
+      s = i;
+  return new StatisticsEmitter(o,tallies,s);
+}
+
+void StatisticsEmitter::arrayLength(const char *name, unsigned int count)
+{
+  arrays[name] += count;
+}
+
+void StatisticsEmitter::entity(const char *type)
+{
+  ++entities[type];
+}
+
+void StatisticsEmitter::beginFile(const string &path)
+{
+  out << "Input file " << path << '\n';
+}
+
+void StatisticsEmitter::endFile(const string &path, const char *error)
+{
+  if(error)
+    out << "Error in " << path << ": " << error << '\n';
+  else
+    out << "Done with " << path << '\n';
+}
+
+void StatisticsEmitter::merge()
+{
+  std::lock_guard<std::mutex> lock(tallies->mutex);
+  for(Counts::const_iterator it = entities.begin(); it != entities.end(); ++it)
+    tallies->entities[section][it->first] += it->second;
+  for(Counts::const_iterator it = arrays.begin(); it != arrays.end(); ++it)
+    tallies->arrays[section][it->first] += it->second;
+  entities.clear();
+  arrays.clear();
+}
+
+void StatisticsEmitter::writeCounts(const Counts &counts, const char *unit)
+{
+  for(Counts::const_iterator it = counts.begin(); it != counts.end(); ++it)
+    out << "  " << it->first << ' ' << it->second << unit << '\n';
+}
+
+void StatisticsEmitter::flush()
+{
+  merge();
+  if(whole)
+  {
+    // by now all parts have been merged
+    std::lock_guard<std::mutex> lock(tallies->mutex);
+    Counts totalEntities, totalArrays;
+    for(unsigned int s = 0; s < NUMBER_OF_SECTIONS; ++s)
+    {
+      if(tallies->entities[s].empty() && tallies->arrays[s].empty())
+        continue;
+      out << "Section " << statisticsSectionNames[s] << '\n';
+      writeCounts(tallies->entities[s],"");
+      writeCounts(tallies->arrays[s]," values");
+      for(Counts::const_iterator it = tallies->entities[s].begin();
+          it != tallies->entities[s].end(); ++it)
+        totalEntities[it->first] += it->second;
+      for(Counts::const_iterator it = tallies->arrays[s].begin();
+          it != tallies->arrays[s].end(); ++it)
+        totalArrays[it->first] += it->second;
+      tallies->entities[s].clear();
+      tallies->arrays[s].clear();
+    }
+    if(!totalEntities.empty() || !totalArrays.empty())
+    {
+      out << "Total\n";
+      writeCounts(totalEntities,"");
+      writeCounts(totalArrays," values");
+    }
+  }
+  DescribeEmitter::flush();
+}
+
+// profile
+
+ProfileEmitter::ProfileEmitter(OutputSink &o) : DescribeEmitter(o),
+    tallies(new Tallies),whole(true),lastPosition(0)
+{
+}
+
+ProfileEmitter::ProfileEmitter(OutputSink &o,
+    const std::shared_ptr<Tallies> &t) : DescribeEmitter(o),tallies(t),
+    whole(false),lastPosition(0)
+{
+}
+
+ProfileEmitter::~ProfileEmitter()
+{
+  setSource(NULL);
+}
+
+DescribeEmitter* ProfileEmitter::createPart(OutputSink &o, const string&) const
+{
+  return new ProfileEmitter(o,tallies);
+}
+
+void ProfileEmitter::setSource(BitByBitData *s)
+{
+  closeEntities();
+  if(source != NULL)
+    source->setDoubleProfile(NULL);
+  source = s;
+  if(source != NULL)
+    source->setDoubleProfile(&doubles);
+  lastPosition = bitPosition();
+}
+
+uint64_t ProfileEmitter::bitPosition() const
+{
+  if(source == NULL)
+    return 0;
+  BitPosition bp = source->getPosition();
+  return bp.byteIndex*8+bp.bitIndex;
+}
+
+void ProfileEmitter::charge(const char *label)
+{
+  uint64_t position = bitPosition();
+  // a describe function may go back to read something again
+  uint64_t bits = position > lastPosition ? position-lastPosition : 0;
+  lastPosition = position;
+
+  // "control point 3 4: " -> "control point", to add up all of them
+  size_t length = strlen(label);
+  while(length > 0 && strchr(" :=0123456789",label[length-1]) != NULL)
+    --length;
+  string entityType = open.empty() ? string("(no entity)") : open.back().type;
+  FieldCost &field = fields[entityType+": "+string(label,length)];
+  ++field.count;
+  field.bits += bits;
+  for(unsigned int i = 0; i < NUMBER_OF_DOUBLE_ENCODINGS; ++i)
+  {
+    field.doubles.count[i] += doubles.count[i]-charged.count[i];
+    field.doubles.bits[i] += doubles.bits[i]-charged.bits[i];
+  }
+  charged = doubles;
+  entities[entityType].ownBits += bits;
+}
+
+void ProfileEmitter::entity(const char *type)
+{
+  // what was read before the entity started belongs to its parent
+  if(bitPosition() != lastPosition)
+    charge("(other)");
+  OpenEntity e;
+  e.type = type;
+  e.start = lastPosition;
+  open.push_back(e);
+}
+
+void ProfileEmitter::endEntity()
+{
+  if(open.empty())
+    return;
+  if(bitPosition() != lastPosition)
+    charge("(other)");
+  EntityCost &cost = entities[open.back().type];
+  ++cost.count;
+  if(lastPosition > open.back().start)
+    cost.bits += lastPosition-open.back().start;
+  open.pop_back();
+}
+
+void ProfileEmitter::closeEntities()
+{
+  while(!open.empty())
+    endEntity();
+}
+
+void ProfileEmitter::merge()
+{
+  closeEntities();
+  std::lock_guard<std::mutex> lock(tallies->mutex);
+  for(EntityCosts::const_iterator it = entities.begin();
+      it != entities.end(); ++it)
+  {
+    EntityCost &total = tallies->entities[it->first];
+    total.count += it->second.count;
+    total.bits += it->second.bits;
+    total.ownBits += it->second.ownBits;
+  }
+  for(FieldCosts::const_iterator it = fields.begin(); it != fields.end(); ++it)
+  {
+    FieldCost &total = tallies->fields[it->first];
+    total.count += it->second.count;
+    total.bits += it->second.bits;
+    for(unsigned int i = 0; i < NUMBER_OF_DOUBLE_ENCODINGS; ++i)
+    {
+      total.doubles.count[i] += it->second.doubles.count[i];
+      total.doubles.bits[i] += it->second.doubles.bits[i];
+    }
+  }
+  entities.clear();
+  fields.clear();
+}
+
+void ProfileEmitter::beginFile(const string &path)
+{
+  out << "Input file " << path << '\n';
+}
+
+void ProfileEmitter::endFile(const string &path, const char *error)
+{
+  if(error)
+    out << "Error in " << path << ": " << error << '\n';
+  else
+    out << "Done with " << path << '\n';
+}
+
+static const char *doubleEncodingNames[NUMBER_OF_DOUBLE_ENCODINGS] =
+    { "frequent", "exponent only", "mantissa" };
+
+template<class Cost>
+static bool moreBits(const std::pair<string,Cost> &a,
+                     const std::pair<string,Cost> &b)
+{
+  return a.second.bits > b.second.bits ||
+      (a.second.bits == b.second.bits && a.first < b.first);
+}
+
+void ProfileEmitter::flush()
+{
+  merge();
+  if(whole)
+  {
+    // by now all parts have been merged
+    std::lock_guard<std::mutex> lock(tallies->mutex);
+    vector<std::pair<string,FieldCost> > fieldList(tallies->fields.begin(),
+                                                   tallies->fields.end());
+    vector<std::pair<string,EntityCost> > entityList(
+        tallies->entities.begin(),tallies->entities.end());
+    tallies->fields.clear();
+    tallies->entities.clear();
+    if(fieldList.empty())
+    {
+      DescribeEmitter::flush();
+      return;
+    }
+    std::sort(fieldList.begin(),fieldList.end(),moreBits<FieldCost>);
+    std::sort(entityList.begin(),entityList.end(),moreBits<EntityCost>);
+
+    uint64_t totalBits = 0;
+    DoubleProfile totalDoubles;
+    for(unsigned int i = 0; i < fieldList.size(); ++i)
+    {
+      totalBits += fieldList[i].second.bits;
+      for(unsigned int j = 0; j < NUMBER_OF_DOUBLE_ENCODINGS; ++j)
+      {
+        totalDoubles.count[j] += fieldList[i].second.doubles.count[j];
+        totalDoubles.bits[j] += fieldList[i].second.doubles.bits[j];
+      }
+    }
+    out << "Bits read " << totalBits << '\n';
+    out << "Doubles by encoding (count, bits)\n";
+    for(unsigned int j = 0; j < NUMBER_OF_DOUBLE_ENCODINGS; ++j)
+      out << "  " << doubleEncodingNames[j] << ' ' << totalDoubles.count[j]
+          << ' ' << totalDoubles.bits[j] << '\n';
+
+    out << "Entities by bits (count, bits with nested entities, own bits)\n";
+    for(unsigned int i = 0; i < entityList.size(); ++i)
+      if(entityList[i].second.bits > 0 || entityList[i].second.ownBits > 0)
+        out << "  " << entityList[i].first << ' '
+            << entityList[i].second.count << ' '
+            << entityList[i].second.bits << ' '
+            << entityList[i].second.ownBits << '\n';
+
+    out << "Fields by bits (count, bits)\n";
+    for(unsigned int i = 0; i < fieldList.size(); ++i)
+    {
+      const FieldCost &cost = fieldList[i].second;
+      if(cost.bits == 0)
+        break; // the rest are free too
+      out << "  " << fieldList[i].first << ' ' << cost.count << ' '
+          << cost.bits << '\n';
+      for(unsigned int j = 0; j < NUMBER_OF_DOUBLE_ENCODINGS; ++j)
+        if(cost.doubles.count[j] > 0)
+          out << "    " << doubleEncodingNames[j] << " doubles "
+              << cost.doubles.count[j] << ' ' << cost.doubles.bits[j] << '\n';
+    }
+  }
+  DescribeEmitter::flush();
+}
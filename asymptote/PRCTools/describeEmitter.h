@@ -0,0 +1,409 @@
+/************
+*
+*   This file is part of a tool for reading 3D content in the PRC format.
+*   Copyright (C) 2008 Orest Shardt <shardtor (at) gmail dot com>
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU Lesser General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU Lesser General Public License for more details.
+*
+*   You should have received a copy of the GNU Lesser General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*************/
+
+#ifndef __DESCRIBE_EMITTER_H
+#define __DESCRIBE_EMITTER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include "bitData.h"
+#include "outputSink.h"
+
+// Receives what the describe functions find in a PRC file.
+// Labels are passed as they appear in the text output, including the
+// trailing separator, e.g. "number_of_fonts " or "Unit is ".
+class DescribeEmitter
+{
+  public:
+    DescribeEmitter(OutputSink &o) : out(o),source(NULL),depth(0) {}
+    virtual ~DescribeEmitter() {}
+
+    // A new emitter of the same kind writing to o, for describing one
+    // part of a file on another thread. name is unique within the file.
+    virtual DescribeEmitter* createPart(OutputSink &o,
+                                        const std::string &name) const = 0;
+    // output of a part, written in order once the part is done
+    void append(const std::string &text) { out << text; }
+
+    // Emitters that only count things return false. Long lists of values
+    // are then skipped and only their length is passed to arrayLength().
+    virtual bool wantsValues() const { return true; }
+    virtual void arrayLength(const char*, unsigned int) {}
+
+    // the data currently being described, used for bit offsets
+    virtual void setSource(BitByBitData *s) { source = s; }
+    void indent() { ++depth; }
+    void dedent() { if(depth > 0) --depth; }
+
+    // bracket the description of one input file in batch runs; error is
+    // NULL if the file was described completely
+    virtual void beginFile(const std::string &path) = 0;
+    virtual void endFile(const std::string &path, const char *error) = 0;
+
+    virtual void fileStructure(unsigned int index) = 0;
+    virtual void entity(const char *type) = 0;
+    virtual void endEntity() {} // everything of the last entity was read
+    virtual void sectionCode(unsigned int found, unsigned int expected) = 0;
+
+    virtual void field(const char *label, int value,
+                       const char *unit = NULL) = 0;
+    virtual void field(const char *label, unsigned int value,
+                       const char *unit = NULL) = 0;
+    virtual void field(const char *label, double value,
+                       const char *unit = NULL) = 0;
+    virtual void flag(const char *label, bool value) = 0;
+    // a flag the text format has always written without indentation
+    virtual void unindentedFlag(const char *label, bool value)
+    {
+      flag(label,value);
+    }
+    virtual void text(const char *label, const std::string &value,
+                      bool quoted = true) = 0;
+    virtual void coordinates(const char *label, const double *values,
+                             unsigned int count) = 0;
+    virtual void colour(double r, double g, double b) = 0;
+    virtual void row(const unsigned int *values, unsigned int count) = 0;
+    virtual void uuid(const char *label, const unsigned int id[4]) = 0;
+    // The file header and the headers of the file structures. The text
+    // format writes them as describePRC always has: the file header
+    // indented with tabs and its UUIDs like pointers, the UUIDs of the
+    // file structure headers in hexadecimal without padding.
+    virtual void fileHeaderField(const char *label, unsigned int value)
+    {
+      field(label,value);
+    }
+    virtual void fileHeaderUUID(const char *label, const unsigned int id[4])
+    {
+      uuid(label,id);
+    }
+    virtual void structureHeaderUUID(const char *label,
+                                     const unsigned int id[4])
+    {
+      uuid(label,id);
+    }
+    virtual void userData(const std::string &bits) = 0;
+
+    // long lists of values, one level deeper than the current depth
+    virtual void array(const char *name,
+                       const std::vector<double> &values) = 0;
+    virtual void array(const char *name,
+                       const std::vector<unsigned int> &values) = 0;
+
+    virtual void note(const char *message) = 0;
+    virtual void warning(const char *message) = 0;
+    virtual void position() = 0;
+    virtual void blankLine() = 0;
+
+    // raw bits of data that could not be decoded
+    virtual void beginBitDump() = 0;
+    virtual void dumpBit(bool) = 0;
+    virtual void endBitDump() = 0;
+
+    virtual void flush();
+
+  protected:
+    OutputSink &out;
+    BitByBitData *source;
+    unsigned int depth;
+};
+
+// The indented text format that describePRC has always written.
+class TextEmitter : public DescribeEmitter
+{
+  public:
+    TextEmitter(OutputSink &o) : DescribeEmitter(o) {}
+
+    DescribeEmitter* createPart(OutputSink&,const std::string&) const;
+
+    void beginFile(const std::string&);
+    void endFile(const std::string&,const char*);
+    void fileStructure(unsigned int);
+    void entity(const char*);
+    void sectionCode(unsigned int,unsigned int);
+    void field(const char*,int,const char* = NULL);
+    void field(const char*,unsigned int,const char* = NULL);
+    void field(const char*,double,const char* = NULL);
+    void flag(const char*,bool);
+    void unindentedFlag(const char*,bool);
+    void text(const char*,const std::string&,bool = true);
+    void coordinates(const char*,const double*,unsigned int);
+    void colour(double,double,double);
+    void row(const unsigned int*,unsigned int);
+    void uuid(const char*,const unsigned int[4]);
+    void fileHeaderField(const char*,unsigned int);
+    void fileHeaderUUID(const char*,const unsigned int[4]);
+    void structureHeaderUUID(const char*,const unsigned int[4]);
+    void userData(const std::string&);
+    void array(const char*,const std::vector<double>&);
+    void array(const char*,const std::vector<unsigned int>&);
+    void note(const char*);
+    void warning(const char*);
+    void position();
+    void blankLine();
+    void beginBitDump();
+    void dumpBit(bool);
+    void endBitDump();
+
+  private:
+    OutputSink& line(); // start an indented line
+    OutputSink& tabbedLine(); // the same, indented with tabs
+    void writeUnit(const char*);
+
+    std::string indentation;
+};
+
+// One JSON object per line (NDJSON). Every event has "event", "depth"
+// and, while a section is being read, "bit", the reader's position in
+// bits when the event was written. Field names are the text labels
+// without their trailing separator.
+//
+// Arrays with at least sideFileThreshold values are appended to the
+// binary files <sideFilePrefix>.f64 and <sideFilePrefix>.u32 in native
+// byte order; the event then gives "file", "offset" in bytes and "count"
+// instead of "values". Without a prefix all arrays are written inline.
+class JSONEmitter : public DescribeEmitter
+{
+  public:
+    JSONEmitter(OutputSink &o,const std::string &sideFilePrefix = "",
+                size_t sideFileThreshold = 1024);
+
+    // parts write their large arrays to <prefix>-<name>.f64/.u32
+    DescribeEmitter* createPart(OutputSink&,const std::string&) const;
+
+    void beginFile(const std::string&);
+    void endFile(const std::string&,const char*);
+    void fileStructure(unsigned int);
+    void entity(const char*);
+    void sectionCode(unsigned int,unsigned int);
+    void field(const char*,int,const char* = NULL);
+    void field(const char*,unsigned int,const char* = NULL);
+    void field(const char*,double,const char* = NULL);
+    void flag(const char*,bool);
+    void text(const char*,const std::string&,bool = true);
+    void coordinates(const char*,const double*,unsigned int);
+    void colour(double,double,double);
+    void row(const unsigned int*,unsigned int);
+    void uuid(const char*,const unsigned int[4]);
+    void userData(const std::string&);
+    void array(const char*,const std::vector<double>&);
+    void array(const char*,const std::vector<unsigned int>&);
+    void note(const char*);
+    void warning(const char*);
+    void position();
+    void blankLine();
+    void beginBitDump();
+    void dumpBit(bool);
+    void endBitDump();
+    void flush();
+
+  private:
+    void begin(const char *event);
+    void name(const char *label);
+    void writeString(const char*,size_t);
+    void writeString(const std::string &s) { writeString(s.data(),s.size()); }
+    void writeDouble(double);
+    void writeUnit(const char*);
+    void end() { out << "}\n"; }
+    bool openSideFile(std::ofstream&,const char *extension);
+
+    std::string prefix;
+    size_t threshold;
+    std::ofstream doubles, integers;
+    uint64_t doublesOffset, integersOffset;
+    std::string dumpedBits;
+};
+
+// Counts entities and array values per section instead of writing them.
+// The counts of all parts are added up and written as a short text
+// summary when the emitter that was given to iPRCFile::describe() is
+// flushed.
+class StatisticsEmitter : public DescribeEmitter
+{
+  public:
+    StatisticsEmitter(OutputSink &o);
+
+    DescribeEmitter* createPart(OutputSink&,const std::string&) const;
+    bool wantsValues() const { return false; }
+    void arrayLength(const char*,unsigned int);
+
+    void beginFile(const std::string&);
+    void endFile(const std::string&,const char*);
+    void entity(const char*);
+    void array(const char *name, const std::vector<double> &values)
+    {
+      arrayLength(name,values.size());
+    }
+    void array(const char *name, const std::vector<unsigned int> &values)
+    {
+      arrayLength(name,values.size());
+    }
+    void flush();
+
+    // nothing else is counted
+    void fileStructure(unsigned int) {}
+    void sectionCode(unsigned int,unsigned int) {}
+    void field(const char*,int,const char* = NULL) {}
+    void field(const char*,unsigned int,const char* = NULL) {}
+    void field(const char*,double,const char* = NULL) {}
+    void flag(const char*,bool) {}
+    void text(const char*,const std::string&,bool = true) {}
+    void coordinates(const char*,const double*,unsigned int) {}
+    void colour(double,double,double) {}
+    void row(const unsigned int*,unsigned int) {}
+    void uuid(const char*,const unsigned int[4]) {}
+    void userData(const std::string&) {}
+    void note(const char*) {}
+    void warning(const char*) {}
+    void position() {}
+    void blankLine() {}
+    void beginBitDump() {}
+    void dumpBit(bool) {}
+    void endBitDump() {}
+
+  private:
+    typedef std::map<std::string,uint64_t> Counts;
+    // sections in file order, see iPRCFile::partName()
+    enum { HEADER, GLOBALS, TREE, TESSELLATION, GEOMETRY, EXTRA_GEOMETRY,
+           MODEL_FILE, NUMBER_OF_SECTIONS };
+    struct Tallies
+    {
+      std::mutex mutex;
+      Counts entities[NUMBER_OF_SECTIONS];
+      Counts arrays[NUMBER_OF_SECTIONS];
+    };
+
+    StatisticsEmitter(OutputSink&,const std::shared_ptr<Tallies>&,
+                      unsigned int section);
+    void merge();
+    void writeCounts(const Counts&,const char *unit);
+
+    std::shared_ptr<Tallies> tallies; // shared with the parts
+    unsigned int section;
+    bool whole; // not a part, writes the summary
+    Counts entities, arrays; // not merged yet
+};
+
+// Finds out which entities and fields take up the bits of a file. Every
+// event is charged with the bits read since the previous one, under its
+// label and the innermost entity that has not ended. Entities are also
+// charged with everything read between their start and end, nested
+// entities included. Doubles are split by how they were encoded. The
+// costs of all parts are added up and written as a report, largest
+// first, when the emitter given to iPRCFile::describe() is flushed.
+class ProfileEmitter : public DescribeEmitter
+{
+  public:
+    ProfileEmitter(OutputSink &o);
+    ~ProfileEmitter();
+
+    DescribeEmitter* createPart(OutputSink&,const std::string&) const;
+    void setSource(BitByBitData*);
+    bool wantsValues() const { return false; }
+    void arrayLength(const char *name,unsigned int) { charge(name); }
+
+    void beginFile(const std::string&);
+    void endFile(const std::string&,const char*);
+    void fileStructure(unsigned int) {}
+    void entity(const char*);
+    void endEntity();
+    void sectionCode(unsigned int,unsigned int) { charge("section code"); }
+    void field(const char *label,int,const char* = NULL) { charge(label); }
+    void field(const char *label,unsigned int,const char* = NULL)
+    {
+      charge(label);
+    }
+    void field(const char *label,double,const char* = NULL) { charge(label); }
+    void flag(const char *label,bool) { charge(label); }
+    void text(const char *label,const std::string&,bool = true)
+    {
+      charge(label);
+    }
+    void coordinates(const char *label,const double*,unsigned int)
+    {
+      charge(label);
+    }
+    void colour(double,double,double) { charge("colour"); }
+    void row(const unsigned int*,unsigned int) { charge("row"); }
+    void uuid(const char *label,const unsigned int[4]) { charge(label); }
+    void userData(const std::string&) { charge("user data"); }
+    void array(const char *name,const std::vector<double>&) { charge(name); }
+    void array(const char *name,const std::vector<unsigned int>&)
+    {
+      charge(name);
+    }
+    void note(const char*) { charge("(other)"); }
+    void warning(const char*) { charge("(other)"); }
+    void position() { charge("(other)"); }
+    void blankLine() { charge("(other)"); }
+    void beginBitDump() { charge("(other)"); }
+    void dumpBit(bool) {}
+    void endBitDump() { charge("(undecoded bits)"); }
+    void flush();
+
+  private:
+    struct EntityCost
+    {
+      EntityCost() : count(0),bits(0),ownBits(0) {}
+      uint64_t count;
+      uint64_t bits; // nested entities included
+      uint64_t ownBits;
+    };
+    struct FieldCost
+    {
+      FieldCost() : count(0),bits(0) {}
+      uint64_t count;
+      uint64_t bits;
+      DoubleProfile doubles;
+    };
+    typedef std::map<std::string,EntityCost> EntityCosts;
+    typedef std::map<std::string,FieldCost> FieldCosts; // "entity: field"
+    struct Tallies
+    {
+      std::mutex mutex;
+      EntityCosts entities;
+      FieldCosts fields;
+    };
+    struct OpenEntity
+    {
+      std::string type;
+      uint64_t start;
+    };
+
+    ProfileEmitter(OutputSink&,const std::shared_ptr<Tallies>&);
+    uint64_t bitPosition() const;
+    void charge(const char *label);
+    void closeEntities();
+    void merge();
+
+    std::shared_ptr<Tallies> tallies; // shared with the parts
+    bool whole; // not a part, writes the report
+    std::vector<OpenEntity> open;
+    uint64_t lastPosition;
+    DoubleProfile doubles; // of every double read from the source
+    DoubleProfile charged; // the part of doubles that was charged already
+    EntityCosts entities; // not merged yet
+    FieldCosts fields;
+};
+
+#endif // __DESCRIBE_EMITTER_H
@@ -19,27 +19,479 @@
 *************/
 
 #include <iostream>
+#include <cstdlib>
 #include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <filesystem>
+#include <random>
 #include "iPRCFile.h"
+#include "pdfFile.h"
+#include "entityIndex.h"
+#include "describePRC.h"
+#include "sectionCache.h"
+#include "describeEmitter.h"
+#include "threadPool.h"
 
 using namespace std;
+namespace fs = std::filesystem;
+
+enum OutputFormat { TEXT, JSON, STATISTICS, PROFILE };
+
+static DescribeEmitter* createEmitter(OutputFormat format, OutputSink &sink,
+                                      const string &arrayPrefix)
+{
+  switch(format)
+  {
+    case JSON:
+      return new JSONEmitter(sink,arrayPrefix);
+    case STATISTICS:
+      return new StatisticsEmitter(sink);
+    case PROFILE:
+      return new ProfileEmitter(sink);
+    default:
+      return new TextEmitter(sink);
+  }
+}
+
+struct BatchFile
+{
+  string path;
+  string name; // of its result file, relative and unique within the batch
+  uintmax_t size;
+};
+
+// the .prc and .pdf files in a directory and its subdirectories, or the files
+// listed one per line in a text file
+static bool findBatchFiles(const string &input, vector<BatchFile> &files)
+{
+  error_code error;
+  if(fs::is_directory(input,error))
+  {
+    for(fs::recursive_directory_iterator it(input,error), end;
+        !error && it != end; it.increment(error))
+      if(it->is_regular_file(error) && (it->path().extension() == ".prc" ||
+                                        it->path().extension() == ".pdf"))
+      {
+        BatchFile file;
+        file.path = it->path().string();
+        file.name = fs::relative(it->path(),input,error).string();
+        files.push_back(file);
+      }
+    if(error)
+    {
+      cerr << "Error: Cannot read directory " << input << ": "
+           << error.message() << endl;
+      return false;
+    }
+  }
+  else
+  {
+    ifstream list(input.c_str());
+    if(!list)
+    {
+      cerr << "Error: Cannot open file list " << input << "." << endl;
+      return false;
+    }
+    string line;
+    while(getline(list,line))
+    {
+      if(!line.empty() && line[line.size()-1] == '\r')
+        line.erase(line.size()-1);
+      if(line.empty())
+        continue;
+      BatchFile file;
+      file.path = line;
+      file.name = fs::path(line).relative_path().string();
+      files.push_back(file);
+    }
+  }
+
+  set<string> names;
+  for(unsigned int i = 0; i < files.size(); ++i)
+  {
+    // result files keep the directories of the inputs, with .. turned
+    // into a plain name so that they stay inside the output directory;
+    // a file listed twice gets a number added
+    fs::path name;
+    for(const fs::path &part : fs::path(files[i].name).lexically_normal())
+      if(!part.empty() && part != ".")
+        name /= (part == ".." ? fs::path("__") : part);
+    files[i].name = name.generic_string();
+    for(unsigned int n = 2; !names.insert(files[i].name).second; ++n)
+      files[i].name = name.generic_string() + "-" + to_string(n);
+    files[i].size = fs::file_size(files[i].path,error);
+    if(error)
+      files[i].size = 0;
+  }
+  // largest first, so the last files to finish are small ones
+  sort(files.begin(),files.end(),
+       [](const BatchFile &a, const BatchFile &b) { return a.size > b.size; });
+  return true;
+}
+
+// Describe each PRC file of an input, a PRC stream of a PDF file being
+// a file of its own. Returns NULL on success, otherwise the reason the
+// last failing file failed.
+static const char* describeInput(const PRCInput &input,
+                                 DescribeEmitter &emitter,
+                                 SectionCache *cache)
+{
+  const char *error = NULL;
+  for(unsigned int i = 0; i < input.getNumberOfFiles(); ++i)
+  {
+    const char *fileError = NULL;
+    string name = input.getName(i);
+    emitter.beginFile(name);
+    {
+      iPRCFile *prcFile = input.open(i);
+      prcFile->setSectionCache(cache);
+      if(!prcFile->isValid())
+        fileError = "Cannot read input file.";
+      else if(!prcFile->describe(emitter))
+        fileError = "Unexpected end of data.";
+      delete prcFile;
+    }
+    emitter.endFile(name,fileError);
+    if(fileError)
+      error = fileError;
+  }
+  return error;
+}
+
+// returns NULL on success, otherwise the reason the file failed
+static const char* describeBatchFile(const BatchFile &file, OutputSink &sink,
+                                     OutputFormat format,
+                                     const string &arrayPrefix,
+                                     SectionCache *cache)
+{
+  DescribeEmitter *emitter = createEmitter(format,sink,arrayPrefix);
+
+  const char *error = NULL;
+  PRCInput input(file.path);
+  if(input.isValid() && input.getNumberOfFiles() > 0)
+    error = describeInput(input,*emitter,cache);
+  else
+  {
+    error = input.isValid() ? "No PRC streams found." :
+        "Cannot read input file.";
+    emitter->beginFile(file.path);
+    emitter->endFile(file.path,error);
+  }
+  emitter->flush();
+  delete emitter;
+  return error;
+}
+
+// a file name in the temporary directory that nobody else uses
+static string temporaryFileName()
+{
+  random_device random;
+  ostringstream name;
+  name << "describePRC-" << hex << random() << random() << ".tmp";
+  error_code error;
+  return (fs::temp_directory_path(error) / name.str()).string();
+}
+
+// Describe the files on all threads. Each file's result goes to
+// <outputDirectory>/<name>.txt or .ndjson, or, without an output
+// directory, to cout as one block per file in the order they finish.
+static int describeBatch(const string &input, const string &outputDirectory,
+                         OutputFormat format, SectionCache *cache)
+{
+  vector<BatchFile> files;
+  if(!findBatchFiles(input,files))
+    return 1;
+  if(!outputDirectory.empty())
+  {
+    error_code error;
+    fs::create_directories(outputDirectory,error);
+    if(error)
+    {
+      cerr << "Error: Cannot create directory " << outputDirectory << ": "
+           << error.message() << endl;
+      return 1;
+    }
+  }
+
+  mutex outputMutex;
+  unsigned int failures = 0;
+  ThreadPool::global().parallelFor(files.size(),[&](unsigned int i)
+  {
+    const BatchFile &file = files[i];
+    const char *error;
+    if(outputDirectory.empty())
+    {
+      // The result is written to a temporary file and copied to cout
+      // when it is complete, so that the files being described at the
+      // same time are not held in memory.
+      const string temporaryName = temporaryFileName();
+      bool created;
+      {
+        ofstream result(temporaryName.c_str(),ios::out | ios::binary);
+        created = result.good();
+        if(!created)
+          error = "Cannot create temporary file.";
+        else
+        {
+          OutputSink sink(result,1<<16);
+          error = describeBatchFile(file,sink,format,"",cache);
+        }
+      }
+      if(created)
+      {
+        ifstream result(temporaryName.c_str(),ios::in | ios::binary);
+        lock_guard<mutex> lock(outputMutex);
+        if(result.peek() != ifstream::traits_type::eof())
+          cout << result.rdbuf();
+        cout.flush();
+      }
+      error_code removeError;
+      fs::remove(temporaryName,removeError);
+    }
+    else
+    {
+      string resultName = outputDirectory + "/" + file.name;
+      string extension = format == JSON ? ".ndjson" : ".txt";
+      error_code directoryError;
+      fs::create_directories(fs::path(resultName).parent_path(),directoryError);
+      ofstream result((resultName+extension).c_str(),ios::out | ios::binary);
+      if(!result)
+        error = "Cannot create result file.";
+      else
+      {
+        // large arrays go next to the result
+        OutputSink sink(result);
+        error = describeBatchFile(file,sink,format,resultName,cache);
+      }
+    }
+    if(error)
+    {
+      lock_guard<mutex> lock(outputMutex);
+      cerr << "Error: " << file.path << ": " << error << endl;
+      ++failures;
+    }
+  });
+
+  cerr << files.size()-failures << " of " << files.size()
+       << " files described." << endl;
+  return failures == 0 ? 0 : 2;
+}
+
+// The sidecar index of a PRC file, <file>.idx, built and written first
+// if it is missing or out of date, or if rebuild is set.
+static void loadIndex(iPRCFile &file, const string &fileName,
+                      EntityIndex &index, bool rebuild)
+{
+  const string indexName = fileName + ".idx";
+  if(!rebuild && index.read(indexName,file) &&
+     index.getNumberOfParts() == file.getNumberOfParts())
+    return;
+  index.build(file);
+  if(!index.write(indexName))
+    cerr << "Warning: Cannot write index file " << indexName << "." << endl;
+}
+
+// number of entities of each type, per part
+static void summarizeIndex(iPRCFile &file, const EntityIndex &index)
+{
+  for(unsigned int p = 0; p < index.getNumberOfParts(); ++p)
+  {
+    const vector<IndexEntry> &entries = index.getEntries(p);
+    if(entries.empty())
+      continue;
+    map<string,unsigned int> counts;
+    for(unsigned int e = 0; e < entries.size(); ++e)
+      ++counts[index.getTypeName(entries[e].type)];
+    cout << file.partName(p) << ':' << endl;
+    for(map<string,unsigned int>::const_iterator it = counts.begin();
+        it != counts.end(); ++it)
+      cout << "  " << it->second << ' ' << it->first << endl;
+  }
+}
+
+// Describe one entity given as <part>/<type>[<n>], e.g.
+// Structure0-Tree/Product Occurrence[3], without decoding the entities
+// before it.
+static int describeIndexedEntity(iPRCFile &file, const EntityIndex &index,
+                                 const string &path, DescribeEmitter &emitter)
+{
+  string::size_type slash = path.find('/');
+  if(slash == string::npos)
+  {
+    cerr << "Error: Entity " << path << " is not <part>/<type>[<n>]." << endl;
+    return 1;
+  }
+  const string partName = path.substr(0,slash);
+  string type = path.substr(slash+1);
+  unsigned int n = 0;
+  string::size_type bracket = type.find('[');
+  if(bracket != string::npos)
+  {
+    n = atoi(type.c_str()+bracket+1);
+    type.erase(bracket);
+  }
+  unsigned int part = 0;
+  while(part < file.getNumberOfParts() && file.partName(part) != partName)
+    ++part;
+  const IndexEntry *entry = index.find(part,type,n);
+  if(entry == NULL)
+  {
+    cerr << "Error: Entity " << path << " not found." << endl;
+    return 1;
+  }
+
+  SectionData section = file.getPartData(part);
+  BitByBitData data(section.data.get(),section.length);
+  data.setPosition(entry->position);
+  emitter.setSource(&data);
+  PRCDescriber describer(emitter);
+  bool described = describer.describeEntity(data,type);
+  emitter.setSource(NULL);
+  emitter.flush();
+  if(!described)
+  {
+    cerr << "Error: Entities of type " << type
+         << " cannot be described on their own." << endl;
+    return 1;
+  }
+  return data.readFailed() ? 2 : 0;
+}
 
 int main(int argc, char* argv[])
 {
-  if(argc < 2)
+  // describePRC [-json [-arrays prefix] | -stats | -profile] file.prc|pdf
+  // describePRC -batch [-json | -stats | -profile] [-out directory]
+  //             list.txt|directory
+  // describePRC -index file.prc
+  // all forms take [-cache directory [-cachesize megabytes]]
+  // describePRC [-json | -stats | -profile] -entity part/type[n] file.prc
+  OutputFormat format = TEXT;
+  bool batch = false;
+  bool buildIndex = false;
+  string entityPath;
+  string arrayPrefix;
+  string outputDirectory;
+  string cacheDirectory;
+  uint64_t cacheSize = 4096; // MB
+  int arg = 1;
+  for(; arg < argc-1 && argv[arg][0] == '-'; ++arg)
+  {
+    if(string(argv[arg]) == "-json")
+      format = JSON;
+    else if(string(argv[arg]) == "-stats")
+      format = STATISTICS;
+    else if(string(argv[arg]) == "-profile")
+      format = PROFILE;
+    else if(string(argv[arg]) == "-batch")
+      batch = true;
+    else if(string(argv[arg]) == "-arrays" && arg+1 < argc-1)
+      arrayPrefix = argv[++arg];
+    else if(string(argv[arg]) == "-out" && arg+1 < argc-1)
+      outputDirectory = argv[++arg];
+    else if(string(argv[arg]) == "-cache" && arg+1 < argc-1)
+      cacheDirectory = argv[++arg];
+    else if(string(argv[arg]) == "-cachesize" && arg+1 < argc-1)
+      cacheSize = strtoull(argv[++arg],NULL,10);
+    else if(string(argv[arg]) == "-index")
+      buildIndex = true;
+    else if(string(argv[arg]) == "-entity" && arg+1 < argc-1)
+      entityPath = argv[++arg];
+    else
+    {
+      cerr << "Error: Unknown option " << argv[arg] << endl;
+      return 1;
+    }
+  }
+  if(arg >= argc)
   {
     cerr << "Error: Input file not specified." << endl;
     return 1;
   }
-  ifstream inFile(argv[1]);
-  if(!inFile)
+  std::unique_ptr<SectionCache> cache;
+  if(!cacheDirectory.empty())
+  {
+    cache.reset(new SectionCache(cacheDirectory,cacheSize << 20));
+    if(!cache->isValid())
+      return 1;
+  }
+  if(batch)
+  {
+    if(buildIndex || !entityPath.empty())
+    {
+      cerr << "Error: -index and -entity are not used with -batch." << endl;
+      return 1;
+    }
+    if(!arrayPrefix.empty())
+    {
+      cerr << "Error: -arrays is not used with -batch, large arrays are"
+              " written next to the results in the -out directory." << endl;
+      return 1;
+    }
+    return describeBatch(argv[arg],outputDirectory,format,cache.get());
+  }
+  if(!outputDirectory.empty())
+  {
+    cerr << "Error: -out is only used with -batch." << endl;
+    return 1;
+  }
+
+  PRCInput input(argv[arg]);
+  if(input.isPDF())
+  {
+    if(!input.isValid() || input.getNumberOfFiles() == 0)
+    {
+      cerr << "Error: No PRC streams found in input file." << endl;
+      return 1;
+    }
+    // each stream is bracketed like a file of a batch
+    OutputSink output(cout);
+    DescribeEmitter *emitter = createEmitter(format,output,arrayPrefix);
+    const char *error = describeInput(input,*emitter,cache.get());
+    emitter->flush();
+    delete emitter;
+    return error ? 2 : 0;
+  }
+
+  iPRCFile myFile(argv[arg]);
+  if(!myFile.isValid())
   {
-    cerr << "Error: Cannot open input file." << endl;
+    cerr << "Error: Cannot read input file." << endl;
     return 1;
   }
+  myFile.setSectionCache(cache.get());
 
-  iPRCFile myFile(inFile);
-  myFile.describe();
+  if(buildIndex || !entityPath.empty())
+  {
+    EntityIndex index;
+    loadIndex(myFile,argv[arg],index,buildIndex);
+    if(buildIndex)
+    {
+      summarizeIndex(myFile,index);
+      return 0;
+    }
+    OutputSink output(cout);
+    DescribeEmitter *emitter = createEmitter(format,output,arrayPrefix);
+    int result = describeIndexedEntity(myFile,index,entityPath,*emitter);
+    delete emitter;
+    return result;
+  }
+
+  OutputSink output(cout);
+  DescribeEmitter *emitter = createEmitter(format,output,arrayPrefix);
+  bool complete = myFile.describe(*emitter);
+  delete emitter;
 
+  if(!complete)
+  {
+    cerr << "Error: Unexpected end of data." << endl;
+    return 2;
+  }
   return 0;
 }
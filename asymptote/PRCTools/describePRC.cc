@@ -19,32 +19,123 @@
 *************/
 
 #include <iostream>
-#include <fstream>
-#include <iomanip>
 #include <string>
-#include <sstream>
+#include <vector>
+#include <algorithm>
 
 #include "PRC.h"
 #include "describePRC.h"
 
-using std::ostringstream; using std::cout; using std::endl;
-using std::hex; using std::dec; using std::string; using std::setw;
-using std::setfill;
+using std::string; using std::vector;
+
+PRCDescriber::PRCDescriber(DescribeEmitter &emitter) : out(&emitter)
+{
+  unFlushSerialization();
+}
+
+// Reports an entity and, however the describe function returns, its end.
+class EntityScope
+{
+  public:
+    EntityScope(DescribeEmitter *e, const char *type) : emitter(e)
+    {
+      emitter->entity(type);
+    }
+    ~EntityScope() { emitter->endEntity(); }
+
+  private:
+    DescribeEmitter *emitter;
+};
+
+// Read count values into a list for DescribeEmitter::array(), or only
+// move past them if the emitter does not want the values.
+void PRCDescriber::describeDoubles(BitByBitData &mData, const char *name,
+                                   unsigned int count)
+{
+  if(!out->wantsValues())
+  {
+    unsigned int i = 0;
+    for(; i < count && !mData.readFailed(); ++i)
+      mData.readDouble();
+    out->arrayLength(name,i);
+    return;
+  }
+  vector<double> values;
+  values.reserve(std::min(count,1u << 20)); // count may be garbage
+  for(unsigned int i = 0; i < count && !mData.readFailed(); ++i)
+    values.push_back(mData.readDouble());
+  out->array(name,values);
+}
+
+void PRCDescriber::describeUnsignedInts(BitByBitData &mData, const char *name,
+                                        unsigned int count)
+{
+  if(!out->wantsValues())
+  {
+    unsigned int i = 0;
+    for(; i < count && !mData.readFailed(); ++i)
+      mData.readUnsignedInt();
+    out->arrayLength(name,i);
+    return;
+  }
+  vector<unsigned int> values;
+  values.reserve(std::min(count,1u << 20));
+  for(unsigned int i = 0; i < count && !mData.readFailed(); ++i)
+    values.push_back(mData.readUnsignedInt());
+  out->array(name,values);
+}
+
+// The entities that can be described on their own, by the type they
+// report to the emitter.
+struct EntityDescription
+{
+  const char *type;
+  void (PRCDescriber::*describe)(BitByBitData&);
+};
+static const EntityDescription entityDescriptions[] =
+{
+  { "Picture", &PRCDescriber::describePicture },
+  { "Texture Definition", &PRCDescriber::describeTextureDefinition },
+  { "Material", &PRCDescriber::describeMaterial },
+  { "Line Pattern", &PRCDescriber::describeLinePattern },
+  { "Category 1 Line Style", &PRCDescriber::describeCategory1LineStyle },
+  { "Fill Pattern", &PRCDescriber::describeFillPattern },
+  { "Representation Item", &PRCDescriber::describeRepresentationItem },
+  { "Part Definition", &PRCDescriber::describePartDefinition },
+  { "Product Occurrence", &PRCDescriber::describeProductOccurrence },
+  { "File Structure Internal Data",
+    &PRCDescriber::describeFileStructureInternalData },
+  { "3D Tessellation", &PRCDescriber::describe3DTess },
+  { "Topological Context", &PRCDescriber::describeTopoContext },
+  { "Body", &PRCDescriber::describeBody }
+};
+
+bool PRCDescriber::describeEntity(BitByBitData &mData, const string &type)
+{
+  for(unsigned int i = 0;
+      i < sizeof(entityDescriptions)/sizeof(entityDescriptions[0]); ++i)
+    if(type == entityDescriptions[i].type)
+    {
+      (this->*entityDescriptions[i].describe)(mData);
+      return true;
+    }
+  return false;
+}
 
 // describe sections
 
-void describeGlobals(BitByBitData &mData)
+void PRCDescriber::describeGlobals(BitByBitData &mData)
 {
-  mData.tellPosition();
-  cout << getIndent() << "--Globals--" << endl;
+  out->position();
+  EntityScope scope(out,"Globals");
   if(!checkSectionCode(mData,PRC_TYPE_ASM_FileStructureGlobals))
     return;
   indent();
 
   describeContentPRCBase(mData,false);
   unsigned int numberOfReferencedFileStructures = mData.readUnsignedInt();
-  cout << getIndent() << "numberOfReferencedFileStructures "
-      << numberOfReferencedFileStructures << endl;
+  out->field("numberOfReferencedFileStructures ",
+      numberOfReferencedFileStructures);
   indent();
   for(unsigned int i = 0; i < numberOfReferencedFileStructures; ++i)
   {
@@ -53,60 +144,55 @@ void describeGlobals(BitByBitData &mData)
   dedent();
 
   double tessellation_chord_height_ratio = mData.readDouble();
-  cout << getIndent() << "tessellation_chord_height_ratio "
-      << tessellation_chord_height_ratio << endl;
+  out->field("tessellation_chord_height_ratio ",
+      tessellation_chord_height_ratio);
 
   double tessellation_angle_degree = mData.readDouble();
-  cout << getIndent() << "tessellation_angle_degree "
-      << tessellation_angle_degree << endl;
+  out->field("tessellation_angle_degree ",tessellation_angle_degree);
 
   string default_font_family_name = mData.readString();
-  cout << getIndent() << "default_font_family_name \""
-      << default_font_family_name << '\"' << endl;
+  out->text("default_font_family_name ",default_font_family_name);
 
   unsigned int number_of_fonts = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_fonts " << number_of_fonts << endl;
+  out->field("number_of_fonts ",number_of_fonts);
 
   indent();
   for(unsigned int q = 0; q < number_of_fonts; ++q)
   {
     string font_name = mData.readString();
-    cout << getIndent() << "font_name \"" << font_name << '\"' << endl;
+    out->text("font_name ",font_name);
     unsigned int char_set = mData.readUnsignedInt();
-    cout << getIndent() << "char_set " << char_set << endl;
+    out->field("char_set ",char_set);
     unsigned int number_of_font_keys = mData.readUnsignedInt();
-    cout << getIndent() << "number_of_font_keys " << number_of_font_keys
-        << endl;
+    out->field("number_of_font_keys ",number_of_font_keys);
     indent();
     for(unsigned int i = 0; i < number_of_font_keys; i++)
     {
       unsigned int font_size = mData.readUnsignedInt() - 1;
-      cout << getIndent() << "font_size " << font_size << endl;
+      out->field("font_size ",font_size);
       unsigned char attributes = mData.readChar();
-      cout << getIndent() << "attributes "
-          << static_cast<unsigned int>(attributes) << endl;
+      out->field("attributes ",static_cast<unsigned int>(attributes));
     }
     dedent();
   }
   dedent();
 
   unsigned int number_of_colours = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_colours " << number_of_colours << endl;
+  out->field("number_of_colours ",number_of_colours);
   indent();
   for(unsigned int i = 0; i < number_of_colours; ++i)
     describeRGBColour(mData);
   dedent();
 
   unsigned int number_of_pictures = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_pictures " << number_of_pictures << endl;
+  out->field("number_of_pictures ",number_of_pictures);
   indent();
   for(unsigned int i=0;i<number_of_pictures;i++)
     describePicture(mData);
   dedent();
 
   unsigned int number_of_texture_definitions = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_texture_definitions "
-      << number_of_texture_definitions << endl;
+  out->field("number_of_texture_definitions ",number_of_texture_definitions);
   indent();
   for(unsigned int i=0;i<number_of_texture_definitions;i++)
     describeTextureDefinition(mData);
@@ -114,38 +200,36 @@ void describeGlobals(BitByBitData &mData)
 
 
   unsigned int number_of_materials = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_materials " << number_of_materials << endl;
+  out->field("number_of_materials ",number_of_materials);
   indent();
   for(unsigned int i=0;i<number_of_materials;i++)
     describeMaterial(mData);
   dedent();
 
   unsigned int number_of_line_patterns = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_line_patterns "
-      << number_of_line_patterns << endl;
+  out->field("number_of_line_patterns ",number_of_line_patterns);
   indent();
   for(unsigned int i=0;i<number_of_line_patterns;i++)
     describeLinePattern(mData);
   dedent();
 
   unsigned int number_of_styles = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_styles " << number_of_styles << endl;
+  out->field("number_of_styles ",number_of_styles);
   indent();
   for(unsigned int i=0;i<number_of_styles;i++)
     describeCategory1LineStyle(mData);
   dedent();
 
   unsigned int number_of_fill_patterns = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_fill_patterns "
-      << number_of_fill_patterns << endl;
+  out->field("number_of_fill_patterns ",number_of_fill_patterns);
   indent();
   for(unsigned int i=0;i<number_of_fill_patterns;i++)
     describeFillPattern(mData);
   dedent();
 
   unsigned int number_of_reference_coordinate_systems = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_reference_coordinate_systems "
-      << number_of_reference_coordinate_systems << endl;
+  out->field("number_of_reference_coordinate_systems ",
+      number_of_reference_coordinate_systems);
   indent();
   for(unsigned int i=0;i<number_of_reference_coordinate_systems;i++)
     //NOTE: must be PRC_TYPE_RI_CoordinateSystem
@@ -154,21 +238,20 @@ void describeGlobals(BitByBitData &mData)
 
   describeUserData(mData);
   dedent();
-  mData.tellPosition();
+  out->position();
 }
 
-void describeTree(BitByBitData &mData)
+void PRCDescriber::describeTree(BitByBitData &mData)
 {
-  mData.tellPosition();
-  cout << getIndent() << "--Tree--" << endl;
+  out->position();
+  EntityScope scope(out,"Tree");
   if(!checkSectionCode(mData,PRC_TYPE_ASM_FileStructureTree))
     return;
   indent();
   describeContentPRCBase(mData,false);
 
   unsigned int number_of_part_definitions = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_part_definitions "
-      << number_of_part_definitions << endl;
+  out->field("number_of_part_definitions ",number_of_part_definitions);
   indent();
   for(unsigned int i = 0; i < number_of_part_definitions; ++i)
   {
@@ -177,8 +260,7 @@ void describeTree(BitByBitData &mData)
   dedent();
 
   unsigned int number_of_product_occurrences = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_product_occurrences "
-      << number_of_product_occurrences << endl;
+  out->field("number_of_product_occurrences ",number_of_product_occurrences);
   indent();
   for(unsigned int i = 0; i < number_of_product_occurrences; ++i)
   {
@@ -190,13 +272,13 @@ void describeTree(BitByBitData &mData)
 
   describeUserData(mData);
   dedent();
-  mData.tellPosition();
+  out->position();
 }
 
-void describeTessellation(BitByBitData &mData)
+void PRCDescriber::describeTessellation(BitByBitData &mData)
 {
-  mData.tellPosition();
-  cout << getIndent() << "--Tessellation--" << endl;
+  out->position();
+  EntityScope scope(out,"Tessellation");
   if(!checkSectionCode(mData,PRC_TYPE_ASM_FileStructureTessellation))
     return;
   indent();
@@ -204,13 +286,12 @@ void describeTessellation(BitByBitData &mData)
   describeContentPRCBase(mData,false);
 
   unsigned int number_of_tessellations = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_tessellations "
-      << number_of_tessellations << endl;
+  out->field("number_of_tessellations ",number_of_tessellations);
   indent();
   for(unsigned int i = 0; i < number_of_tessellations; ++i)
   {
     unsigned int type = mData.readUnsignedInt();
-    cout << getIndent() << "tessellation type " << type << endl;
+    out->field("tessellation type ",type);
     switch(type)
     {
       case PRC_TYPE_TESS_3D:
@@ -226,8 +307,7 @@ void describeTessellation(BitByBitData &mData)
         describeHighlyCompressed3DTess(mData);
         break;
       default:
-        cout << getIndent() << "Unrecognized tessellation data type "
-            << type << endl;
+        out->field("Unrecognized tessellation data type ",type);
         break;
     }
   }
@@ -236,13 +316,13 @@ void describeTessellation(BitByBitData &mData)
   describeUserData(mData);
 
   dedent();
-  mData.tellPosition();
+  out->position();
 }
 
-void describeGeometry(BitByBitData &mData)
+void PRCDescriber::describeGeometry(BitByBitData &mData)
 {
-  mData.tellPosition();
-  cout << getIndent() << "--Geometry--" << endl;
+  out->position();
+  EntityScope scope(out,"Geometry");
   if(!checkSectionCode(mData,PRC_TYPE_ASM_FileStructureGeometry))
     return;
   indent();
@@ -250,14 +330,13 @@ void describeGeometry(BitByBitData &mData)
   describeContentPRCBase(mData,false);
 
   unsigned int number_of_topological_contexts = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_topological_contexts "
-      << number_of_topological_contexts << endl;
+  out->field("number_of_topological_contexts ",number_of_topological_contexts);
   indent();
   for(unsigned int i = 0; i < number_of_topological_contexts; ++i)
   {
     describeTopoContext(mData);
     unsigned int number_of_bodies = mData.readUnsignedInt();
-    cout << getIndent() << "number_of_bodies " << number_of_bodies << endl;
+    out->field("number_of_bodies ",number_of_bodies);
     for(unsigned int i = 0; i < number_of_bodies; ++i)
     {
       describeBody(mData);
@@ -267,13 +346,13 @@ void describeGeometry(BitByBitData &mData)
 
   describeUserData(mData);
   dedent();
-  mData.tellPosition();
+  out->position();
 }
 
-void describeExtraGeometry(BitByBitData &mData)
+void PRCDescriber::describeExtraGeometry(BitByBitData &mData)
 {
-  mData.tellPosition();
-  cout << getIndent() << "--Extra Geometry--" << endl;
+  out->position();
+  EntityScope scope(out,"Extra Geometry");
   if(!checkSectionCode(mData,PRC_TYPE_ASM_FileStructureExtraGeometry))
     return;
   indent();
@@ -281,36 +360,34 @@ void describeExtraGeometry(BitByBitData &mData)
   describeContentPRCBase(mData,false);
 
   unsigned int number_of_contexts = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_contexts " << number_of_contexts << endl;
+  out->field("number_of_contexts ",number_of_contexts);
   indent();
   for(unsigned int i = 0; i < number_of_contexts; ++i)
   {
     // geometry summary
     unsigned int number_of_bodies = mData.readUnsignedInt();
-    cout << getIndent() << "number_of_bodies " << number_of_bodies << endl;
+    out->field("number_of_bodies ",number_of_bodies);
     indent();
     for(unsigned int j = 0; j < number_of_bodies; ++j)
     {
       unsigned int serial_type = mData.readUnsignedInt();
-      cout << getIndent() << "serial_type " << serial_type << endl;
+      out->field("serial_type ",serial_type);
       indent();
       if(isCompressedSerialType(serial_type))
-        cout << getIndent() << "serialTolerance " << mData.readDouble();
+        out->field("serialTolerance ",mData.readDouble());
       dedent();
     }
     dedent();
     // context graphics
     resetCurrentGraphics();
     unsigned int number_of_treat_types = mData.readUnsignedInt();
-    cout << getIndent() << "number_of_treat_types "
-        << number_of_treat_types << endl;
+    out->field("number_of_treat_types ",number_of_treat_types);
     indent();
     for(unsigned int i = 0; i < number_of_treat_types; ++i)
     {
-      cout << getIndent() << "element_type " << mData.readUnsignedInt() << endl;
+      out->field("element_type ",mData.readUnsignedInt());
       unsigned int number_of_elements = mData.readUnsignedInt();
-      cout << getIndent() << "number_of_elements "
-          << number_of_elements << endl;
+      out->field("number_of_elements ",number_of_elements);
       indent();
       for(unsigned int j = 0; j < number_of_elements; ++j)
       {
@@ -320,7 +397,7 @@ void describeExtraGeometry(BitByBitData &mData)
         }
         else
         {
-          cout << getIndent() << "Element has no graphics" << endl;
+          out->note("Element has no graphics");
         }
       }
       dedent();
@@ -331,15 +408,15 @@ void describeExtraGeometry(BitByBitData &mData)
 
   describeUserData(mData);
   dedent();
-  mData.tellPosition();
+  out->position();
 }
 
 
-void describeModelFileData(BitByBitData &mData,
+void PRCDescriber::describeModelFileData(BitByBitData &mData,
                            unsigned int numberOfFileStructures)
 {
-  mData.tellPosition();
-  cout << getIndent() << "--Model File--" << endl;
+  out->position();
+  EntityScope scope(out,"Model File");
   if(!checkSectionCode(mData,PRC_TYPE_ASM_ModelFile))
     return;
   indent();
@@ -348,27 +425,24 @@ void describeModelFileData(BitByBitData &mData,
 
   describeUnit(mData);
   unsigned int numberOfProductOccurrences = mData.readUnsignedInt();
-  cout << getIndent() << "Number of Product Occurrences "
-      << numberOfProductOccurrences << endl;
+  out->field("Number of Product Occurrences ",numberOfProductOccurrences);
   indent();
   for(unsigned int i = 0; i < numberOfProductOccurrences; ++i)
   {
     describeCompressedUniqueID(mData);
-    cout << getIndent() << "index_position + 1 = "
-        << mData.readUnsignedInt() << endl;
-    cout << getIndent() << "active? " << (mData.readBit()?"yes":"no")
-        << endl << endl;
+    out->field("index_position + 1 = ",mData.readUnsignedInt());
+    out->flag("active? ",mData.readBit());
+    out->blankLine();
   }
   dedent();
   for(unsigned int i = 0; i < numberOfFileStructures; ++i)
   {
-    cout << getIndent() << "File Structure Index in Model File "
-        << mData.readUnsignedInt() << endl;
+    out->field("File Structure Index in Model File ",mData.readUnsignedInt());
   }
 
   describeUserData(mData);
   dedent();
-  mData.tellPosition();
+  out->position();
 }
 
 // subsections
@@ -377,78 +451,75 @@ void describeModelFileData(BitByBitData &mData,
 //   
 // }
 
-void describeLight(BitByBitData &mData)
+void PRCDescriber::describeLight(BitByBitData &mData)
 {
   unsigned int ID = mData.readUnsignedInt();
-  if(ID == PRC_TYPE_GRAPH_AmbientLight)
-    cout << getIndent() << "--Ambient Light--" << endl;
-  else
+  if(ID != PRC_TYPE_GRAPH_AmbientLight)
     return;
+  EntityScope scope(out,"Ambient Light");
 
   indent();
 
   describeContentPRCBase(mData,true);
 
-  cout << getIndent() << "ambient colour index: " << mData.readUnsignedInt()-1 << endl
-      << getIndent() << "diffuse colour index: " << mData.readUnsignedInt()-1 << endl
-      << getIndent() << "specular colour index: " << mData.readUnsignedInt()-1 << endl;
+  out->field("ambient colour index: ",mData.readUnsignedInt()-1);
+  out->field("diffuse colour index: ",mData.readUnsignedInt()-1);
+  out->field("specular colour index: ",mData.readUnsignedInt()-1);
 
   describeUserData(mData);
   describeUserData(mData); // why?
   dedent();
 }
 
-void describeCamera(BitByBitData &mData)
+void PRCDescriber::describeCamera(BitByBitData &mData)
 {
-  cout << getIndent() << "--Camera--" << endl;
+  EntityScope scope(out,"Camera");
   if(!checkSectionCode(mData,PRC_TYPE_GRAPH_Camera))
     return;
   indent();
 
   describeContentPRCBase(mData,true);
 
-  cout << getIndent() << (mData.readBit()?"orthographic":"perspective") << endl;
-  cout << getIndent() << "Camera Position" << endl;
+  out->note(mData.readBit()?"orthographic":"perspective");
+  out->note("Camera Position");
   describeVector3d(mData);
-  cout << getIndent() << "Look At Point" << endl;
+  out->note("Look At Point");
   describeVector3d(mData);
-  cout << getIndent() << "Up" << endl;
+  out->note("Up");
   describeVector3d(mData);
-  cout << getIndent() << "X field of view angle (perspective) || X scale (orthographic) "
-      << mData.readDouble() << endl;
-  cout << getIndent() << "Y field of view angle (perspective) || Y scale (orthographic) "
-      << mData.readDouble() << endl;
-  cout << getIndent() << "aspect ratio x/y " << mData.readDouble() << endl;
-  cout << getIndent() << "near z clipping plane distance from viewer " << mData.readDouble() << endl;
-  cout << getIndent() << "far z clipping plane distance from viewer " << mData.readDouble() << endl;
-  cout << getIndent() << "zoom factor " << mData.readDouble() << endl;
+  out->field("X field of view angle (perspective) || X scale (orthographic) ",
+      mData.readDouble());
+  out->field("Y field of view angle (perspective) || Y scale (orthographic) ",
+      mData.readDouble());
+  out->field("aspect ratio x/y ",mData.readDouble());
+  out->field("near z clipping plane distance from viewer ",mData.readDouble());
+  out->field("far z clipping plane distance from viewer ",mData.readDouble());
+  out->field("zoom factor ",mData.readDouble());
   dedent();
 }
 
-bool describeContentCurve(BitByBitData &mData)
+bool PRCDescriber::describeContentCurve(BitByBitData &mData)
 {
   describeBaseGeometry(mData);
-  cout << getIndent() << "extend_info " << mData.readUnsignedInt() << endl;
+  out->field("extend_info ",mData.readUnsignedInt());
   bool is_3d = mData.readBit();
-  cout << getIndent() << "is_3d " << (is_3d?"yes":"no") << endl;
+  out->flag("is_3d ",is_3d);
   return is_3d;
 }
 
-void describeParameterization(BitByBitData &mData)
+void PRCDescriber::describeParameterization(BitByBitData &mData)
 {
-  cout << getIndent() << "--Parameterization--" << endl;
+  EntityScope scope(out,"Parameterization");
   indent();
   describeExtent1d(mData);
-  cout << getIndent() << "parameterization_coeff_a " << mData.readDouble()
-      << endl;
-  cout << getIndent() << "parameterization_coeff_b " << mData.readDouble()
-      << endl;
+  out->field("parameterization_coeff_a ",mData.readDouble());
+  out->field("parameterization_coeff_b ",mData.readDouble());
   dedent();
 }
 
-void describeCurvCircle(BitByBitData &mData)
+void PRCDescriber::describeCurvCircle(BitByBitData &mData)
 {
-  cout << getIndent() << "--Circle--" << endl;
+  EntityScope scope(out,"Circle");
   indent();
 
   if(describeContentCurve(mData))
@@ -458,14 +529,14 @@ void describeCurvCircle(BitByBitData &mData)
 
   describeParameterization(mData);
 
-  cout << getIndent() << "radius " << mData.readDouble() << endl;
+  out->field("radius ",mData.readDouble());
 
   dedent();
 }
 
-void describeCurvLine(BitByBitData &mData)
+void PRCDescriber::describeCurvLine(BitByBitData &mData)
 {
-  cout << getIndent() << "--Line--" << endl;
+  EntityScope scope(out,"Line");
   indent();
 
   if(describeContentCurve(mData))
@@ -478,9 +549,9 @@ void describeCurvLine(BitByBitData &mData)
   dedent();
 }
 
-void describeContentWireEdge(BitByBitData &mData)
+void PRCDescriber::describeContentWireEdge(BitByBitData &mData)
 {
-  cout << getIndent() << "--WireEdge--" << endl;
+  EntityScope scope(out,"WireEdge");
   indent();
 
   describeBaseTopology(mData);
@@ -488,8 +559,7 @@ void describeContentWireEdge(BitByBitData &mData)
   describeObject(mData); //3d_curve
 
   bool curve_trim_interval = mData.readBit();
-  cout << getIndent() << "curve_trim_interval "
-      << (curve_trim_interval?"yes":"no") << endl;
+  out->flag("curve_trim_interval ",curve_trim_interval);
   if(curve_trim_interval)
   {
     describeExtent1d(mData);
@@ -498,154 +568,133 @@ void describeContentWireEdge(BitByBitData &mData)
   dedent();
 }
 
-void describeUVParametrization(BitByBitData &mData)
+void PRCDescriber::describeUVParametrization(BitByBitData &mData)
 {
-  cout << getIndent() << "--UV Parameterization--" << endl;
+  EntityScope scope(out,"UV Parameterization");
   indent();
 
-  cout << getIndent() << "swap_uv " << (mData.readBit()?"yes":"no") << endl;
-  cout << getIndent() << "Domain" << endl;
+  out->flag("swap_uv ",mData.readBit());
+  out->note("Domain");
   indent(); describeExtent2d(mData); dedent();
-  cout << getIndent() << "parameterization_on_u_coeff_a "
-      << mData.readDouble() << endl;
-  cout << getIndent() << "parameterization_on_v_coeff_a "
-      << mData.readDouble() << endl;
-  cout << getIndent() << "parameterization_on_u_coeff_b "
-      << mData.readDouble() << endl;
-  cout << getIndent() << "parameterization_on_v_coeff_b "
-      << mData.readDouble() << endl;
+  out->field("parameterization_on_u_coeff_a ",mData.readDouble());
+  out->field("parameterization_on_v_coeff_a ",mData.readDouble());
+  out->field("parameterization_on_u_coeff_b ",mData.readDouble());
+  out->field("parameterization_on_v_coeff_b ",mData.readDouble());
 
   dedent();
 }
 
-bool isCompressedSerialType(unsigned int type)
+bool PRCDescriber::isCompressedSerialType(unsigned int type)
 {
   return false; // TODO: actually check the type!!!
 }
 
-void describeSurfNURBS(BitByBitData &mData)
+void PRCDescriber::describeSurfNURBS(BitByBitData &mData)
 {
-  cout << getIndent() << "--NURBS surface--" << endl;
+  EntityScope scope(out,"NURBS surface");
   indent();
 
   describeContentSurface(mData);
 
   bool is_rational = mData.readBit();
-  cout << getIndent() << "is_rational " << (is_rational?"yes":"no") << endl;
+  out->flag("is_rational ",is_rational);
 
   unsigned int degree_in_u = mData.readUnsignedInt();
-  cout << getIndent() << "degree_in_u " << degree_in_u << endl;
+  out->field("degree_in_u ",degree_in_u);
   unsigned int degree_in_v = mData.readUnsignedInt();
-  cout << getIndent() << "degree_in_v " << degree_in_v << endl;
+  out->field("degree_in_v ",degree_in_v);
 
   unsigned int number_of_control_points_in_u = mData.readUnsignedInt()+1;
-  cout << getIndent() << "number_of_control_points_in_u "
-      << number_of_control_points_in_u << endl;
+  out->field("number_of_control_points_in_u ",number_of_control_points_in_u);
   unsigned int number_of_control_points_in_v = mData.readUnsignedInt()+1;
-  cout << getIndent() << "number_of_control_points_in_v "
-      << number_of_control_points_in_v << endl;
+  out->field("number_of_control_points_in_v ",number_of_control_points_in_v);
 
   unsigned int number_of_knots_in_u = mData.readUnsignedInt()+1;
-  cout << getIndent() << "number_of_knots_in_u "
-      << number_of_knots_in_u << endl;
+  out->field("number_of_knots_in_u ",number_of_knots_in_u);
   unsigned int number_of_knots_in_v = mData.readUnsignedInt()+1;
-  cout << getIndent() << "number_of_knots_in_v "
-      << number_of_knots_in_v << endl;
+  out->field("number_of_knots_in_v ",number_of_knots_in_v);
 
   indent();
   for(unsigned int i = 0; i < number_of_control_points_in_u; ++i)
   {
     for(unsigned int j = 0; j < number_of_control_points_in_v; ++j)
     {
-      double x = mData.readDouble();
-      double y = mData.readDouble();
-      double z = mData.readDouble();
-      cout << getIndent() << "control point " << i << ' ' << j << ": ("
-          << x << ',' << y << ',' << z;
-
+      double point[4];
+      point[0] = mData.readDouble();
+      point[1] = mData.readDouble();
+      point[2] = mData.readDouble();
       if(is_rational)
-        cout << ',' << mData.readDouble();
-
-      cout << ')' << endl;
+        point[3] = mData.readDouble();
+      string label = "control point " + std::to_string(i) + ' '
+          + std::to_string(j) + ": ";
+      out->coordinates(label.c_str(),point,is_rational ? 4 : 3);
     }
   }
   dedent();
 
-  cout << getIndent() << "knots in u" << endl;
-  indent();
-  for(unsigned int i = 0; i < number_of_knots_in_u; ++i)
-    cout << getIndent() << mData.readDouble() << endl;
-  dedent();
+  out->note("knots in u");
+  describeDoubles(mData,"knots_in_u",number_of_knots_in_u);
 
-  cout << getIndent() << "knots in v" << endl;
-  indent();
-  for(unsigned int i = 0; i < number_of_knots_in_v; ++i)
-    cout << getIndent() << mData.readDouble() << endl;
-  dedent();
+  out->note("knots in v");
+  describeDoubles(mData,"knots_in_v",number_of_knots_in_v);
 
-  cout << getIndent() << "knot_type " << mData.readUnsignedInt() << endl;
-  cout << getIndent() << "surface_form " << mData.readUnsignedInt() << endl;
+  out->field("knot_type ",mData.readUnsignedInt());
+  out->field("surface_form ",mData.readUnsignedInt());
 
   dedent();
 }
 
-void describeCurvNURBS(BitByBitData &mData)
+void PRCDescriber::describeCurvNURBS(BitByBitData &mData)
 {
-  cout << getIndent() << "--NURBS curve--" << endl;
+  EntityScope scope(out,"NURBS curve");
   indent();
   describeContentCurve(mData);
 
   bool is_rational = mData.readBit();
-  cout << getIndent() << "is_rational " << (is_rational?"yes":"no") << endl;
+  out->flag("is_rational ",is_rational);
 
   unsigned int degree = mData.readUnsignedInt();
-  cout << getIndent() << "degree " << degree << endl;
+  out->field("degree ",degree);
 
   unsigned int number_of_control_points = mData.readUnsignedInt()+1;
-  cout << getIndent() << "number_of_control_points "
-      << number_of_control_points << endl;
+  out->field("number_of_control_points ",number_of_control_points);
 
   unsigned int number_of_knots = mData.readUnsignedInt()+1;
-  cout << getIndent() << "number_of_knots " << number_of_knots << endl;
+  out->field("number_of_knots ",number_of_knots);
 
   indent();
   for(unsigned int i = 0; i < number_of_control_points; ++i)
   {
-    double x = mData.readDouble();
-    double y = mData.readDouble();
-    double z = mData.readDouble();
-    cout << getIndent() << "control point " << i << ": ("
-        << x << ',' << y << ',' << z;
-
+    double point[4];
+    point[0] = mData.readDouble();
+    point[1] = mData.readDouble();
+    point[2] = mData.readDouble();
     if(is_rational)
-      cout << ',' << mData.readDouble();
-
-    cout << ')' << endl;
+      point[3] = mData.readDouble();
+    string label = "control point " + std::to_string(i) + ": ";
+    out->coordinates(label.c_str(),point,is_rational ? 4 : 3);
   }
   dedent();
 
-  cout << getIndent() << "knots" << endl;
-  indent();
-  for(unsigned int i = 0; i < number_of_knots; ++i)
-    cout << getIndent() << mData.readDouble() << endl;
-  dedent();
+  out->note("knots");
+  describeDoubles(mData,"knots",number_of_knots);
 
-  cout << getIndent() << "knot_type " << mData.readUnsignedInt() << endl;
-  cout << getIndent() << "surface_form " << mData.readUnsignedInt() << endl;
+  out->field("knot_type ",mData.readUnsignedInt());
+  out->field("surface_form ",mData.readUnsignedInt());
 
   dedent();
 }
 
-void describeCurvPolyLine(BitByBitData &mData)
+void PRCDescriber::describeCurvPolyLine(BitByBitData &mData)
 {
-  cout << getIndent() << "--PolyLine--" << endl;
+  EntityScope scope(out,"PolyLine");
   indent();
   describeContentCurve(mData);
   describeTransformation3d(mData);
   describeParameterization(mData);
 
   unsigned int number_of_points = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_points " << number_of_points << endl;
+  out->field("number_of_points ",number_of_points);
   
   indent();
   for(unsigned int i = 0; i < number_of_points; ++i)
@@ -657,30 +706,30 @@ void describeCurvPolyLine(BitByBitData &mData)
   dedent();
 }
 
-void describeSurfCylinder(BitByBitData &mData)
+void PRCDescriber::describeSurfCylinder(BitByBitData &mData)
 {
-  cout << getIndent() << "--Cylinder surface--" << endl;
+  EntityScope scope(out,"Cylinder surface");
   indent();
 
   describeContentSurface(mData);
   describeTransformation3d(mData);
   describeUVParametrization(mData);
-  cout << getIndent() << "radius " << mData.readDouble() << endl;
+  out->field("radius ",mData.readDouble());
 
   dedent();
 }
 
-void describeSurfPlane(BitByBitData &mData)
+void PRCDescriber::describeSurfPlane(BitByBitData &mData)
 {
-  cout << getIndent() << "--Plane surface--" << endl;
+  EntityScope scope(out,"Plane surface");
   indent();
-  mData.setShowBits(true);
   describeContentSurface(mData);
-  mData.tellPosition();
+  out->position();
   //TODO: something is wrong, very wrong!!!
   // For now, all this does is search until the end of the data block,
   // assuming that the default parameterization [-inf,inf]x[-inf,inf] was used
   BitPosition bp = mData.getPosition();
+  out->beginBitDump();
   double nInf1 = mData.readDouble();
   double nInf2 = mData.readDouble();
   double inf1 = mData.readDouble();
@@ -694,7 +743,7 @@ void describeSurfPlane(BitByBitData &mData)
           && zero2 == 0.0))
   {
     mData.setPosition(bp);
-    cout << mData.readBit();
+    out->dumpBit(mData.readBit());
     bp = mData.getPosition();
 
     nInf1 = mData.readDouble();
@@ -706,7 +755,7 @@ void describeSurfPlane(BitByBitData &mData)
     zero1 = mData.readDouble();
     zero2 = mData.readDouble();
   }
-  cout << endl;
+  out->endBitDump();
   if(bp.bitIndex == 0)
   {
     bp.bitIndex = 7;
@@ -721,38 +770,36 @@ void describeSurfPlane(BitByBitData &mData)
 /*
   // this is what the 8137 docs say it should be
   describeTransformation3d(mData);
-  cout << getIndent() << "UV domain" << endl;
+  out->note("UV domain");
   indent();
-  cout << getIndent() << "Min: " << endl;
+  out->note("Min: ");
   describeVector2d(mData);
-  cout << getIndent() << "Max: " << endl;
+  out->note("Max: ");
   describeVector2d(mData);
   dedent();
 
-  cout << getIndent() << "u coef. a = " << mData.readDouble() << endl;
-  cout << getIndent() << "v coef. a = " << mData.readDouble() << endl;
-  cout << getIndent() << "u coef. b = " << mData.readDouble() << endl;
-  cout << getIndent() << "v coef. b = " << mData.readDouble() << endl;
+  out->field("u coef. a = ",mData.readDouble());
+  out->field("v coef. a = ",mData.readDouble());
+  out->field("u coef. b = ",mData.readDouble());
+  out->field("v coef. b = ",mData.readDouble());
 */
-  mData.setShowBits(false);
   dedent();
 }
 
-void describeTopoFace(BitByBitData &mData)
+void PRCDescriber::describeTopoFace(BitByBitData &mData)
 {
-  cout << getIndent() << "--Face--" << endl;
+  EntityScope scope(out,"Face");
   indent();
 
   describeBaseTopology(mData);
 
-  cout << getIndent() << "base_surface" << endl;
+  out->note("base_surface");
   indent();
   describeObject(mData);
   dedent();
 
   bool surface_trim_domain = mData.readBit();
-  cout << getIndent() << "surface_trim_domain "
-      << (surface_trim_domain?"yes":"no") << endl;
+  out->flag("surface_trim_domain ",surface_trim_domain);
   if(surface_trim_domain)
   {
     indent();
@@ -761,14 +808,13 @@ void describeTopoFace(BitByBitData &mData)
   }
 
   bool have_tolerance = mData.readBit();
-  cout << getIndent() << "have_tolerance "
-      << (have_tolerance?"yes":"no") << endl;
+  out->flag("have_tolerance ",have_tolerance);
   if(have_tolerance)
-    cout << getIndent() << "tolerance " << mData.readDouble() << endl;
+    out->field("tolerance ",mData.readDouble());
 
   unsigned int number_of_loops = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_loops " << number_of_loops << endl;
-  cout << getIndent() << "outer_loop_index " << mData.readInt() << endl;
+  out->field("number_of_loops ",number_of_loops);
+  out->field("outer_loop_index ",mData.readInt());
   indent();
   for(unsigned int i = 0; i < number_of_loops; ++i)
   {
@@ -779,48 +825,47 @@ void describeTopoFace(BitByBitData &mData)
   dedent();
 }
 
-void describeTopoLoop(BitByBitData &mData)
+void PRCDescriber::describeTopoLoop(BitByBitData &mData)
 {
-  cout << getIndent() << "--Loop--" << endl;
+  EntityScope scope(out,"Loop");
   indent();
 
   describeBaseTopology(mData);
   
-  cout << getIndent() << "orientation_with_surface "
-      << static_cast<unsigned int>(mData.readChar()) << endl;
+  out->field("orientation_with_surface ",
+      static_cast<unsigned int>(mData.readChar()));
   unsigned int number_of_coedge = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_coedge " << number_of_coedge << endl;
+  out->field("number_of_coedge ",number_of_coedge);
   indent();
   for(unsigned int i = 0; i < number_of_coedge; ++i)
   {
     describeObject(mData);
-    cout << getIndent() << "neigh_serial_index "
-        << mData.readUnsignedInt() << endl;
+    out->field("neigh_serial_index ",mData.readUnsignedInt());
   }
   dedent();
 
   dedent();
 }
 
-void describeTopoCoEdge(BitByBitData &mData)
+void PRCDescriber::describeTopoCoEdge(BitByBitData &mData)
 {
-  cout << getIndent() << "--CoEdge--" << endl;
+  EntityScope scope(out,"CoEdge");
   indent();
 
   describeBaseTopology(mData);
 
   describeObject(mData); // edge
   describeObject(mData); // uv_curve
-  cout << getIndent() << "orientation_with_loop "
-      << static_cast<unsigned int>(mData.readChar()) << endl;
-  cout << getIndent() << "orientation_uv_with_loop "
-      << static_cast<unsigned int>(mData.readChar()) << endl;
+  out->field("orientation_with_loop ",
+      static_cast<unsigned int>(mData.readChar()));
+  out->field("orientation_uv_with_loop ",
+      static_cast<unsigned int>(mData.readChar()));
   dedent();
 }
 
-void describeTopoEdge(BitByBitData &mData)
+void PRCDescriber::describeTopoEdge(BitByBitData &mData)
 {
-  cout << getIndent() << "--Edge--" << endl;
+  EntityScope scope(out,"Edge");
   indent();
 
   describeContentWireEdge(mData);
@@ -829,38 +874,35 @@ void describeTopoEdge(BitByBitData &mData)
   describeObject(mData); // vertex_end
 
   bool have_tolerance = mData.readBit();
-  cout << getIndent() << "have_tolerance "
-      << (have_tolerance?"yes":"no") << endl;
+  out->flag("have_tolerance ",have_tolerance);
   if(have_tolerance)
-    cout << getIndent() << "tolerance " << mData.readDouble() << endl;
+    out->field("tolerance ",mData.readDouble());
   dedent();
 }
 
-void describeTopoUniqueVertex(BitByBitData &mData)
+void PRCDescriber::describeTopoUniqueVertex(BitByBitData &mData)
 {
-  cout << getIndent() << "--Unique Vertex--" << endl;
+  EntityScope scope(out,"Unique Vertex");
   indent();
 
   describeBaseTopology(mData);
   describeVector3d(mData);
 
   bool have_tolerance = mData.readBit();
-  cout << getIndent() << "have_tolerance "
-      << (have_tolerance?"yes":"no") << endl;
+  out->flag("have_tolerance ",have_tolerance);
   if(have_tolerance)
-    cout << getIndent() << "tolerance " << mData.readDouble() << endl;
+    out->field("tolerance ",mData.readDouble());
 
   dedent();
 }
 
-void describeTopoConnex(BitByBitData &mData)
+void PRCDescriber::describeTopoConnex(BitByBitData &mData)
 {
-  cout << getIndent() << "--Connex--" << endl;
+  EntityScope scope(out,"Connex");
   indent();
   describeBaseTopology(mData);
   unsigned int number_of_shells = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_shells "
-      << number_of_shells << endl;
+  out->field("number_of_shells ",number_of_shells);
   indent();
   for(unsigned int i = 0; i < number_of_shells; ++i)
   {
@@ -872,40 +914,37 @@ void describeTopoConnex(BitByBitData &mData)
   dedent();
 }
 
-void describeTopoShell(BitByBitData &mData)
+void PRCDescriber::describeTopoShell(BitByBitData &mData)
 {
-  cout << getIndent() << "--Shell--" << endl;
+  EntityScope scope(out,"Shell");
   indent();
 
   describeBaseTopology(mData);
 
-  cout << getIndent() << "shell_is_closed "
-      << (mData.readBit()?"yes":"no") << endl;
+  out->flag("shell_is_closed ",mData.readBit());
 
   unsigned int number_of_faces = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_faces " << number_of_faces << endl;
+  out->field("number_of_faces ",number_of_faces);
   for(unsigned int i = 0; i < number_of_faces; ++i)
   {
     // NOTE: this does not check if the objects are actually faces!
     describeObject(mData);
     unsigned char orientation = mData.readChar();
-    cout << getIndent() << "orientation_surface_with_shell "
-        << static_cast<unsigned int>(orientation) << endl;
+    out->field("orientation_surface_with_shell ",
+        static_cast<unsigned int>(orientation));
   }
 
   dedent();
 }
 
-void describeObject(BitByBitData &mData)
+void PRCDescriber::describeObject(BitByBitData &mData)
 {
-  cout << getIndent() << "--Object--" << endl;
+  EntityScope scope(out,"Object");
   bool already_stored = mData.readBit();
-  cout << getIndent() << "already_stored "
-      << (already_stored?"yes":"no") << endl;
+  out->flag("already_stored ",already_stored);
   if(already_stored) // reverse of documentation?
   {
-    cout << getIndent() << "index of stored item "
-        << mData.readUnsignedInt() << endl;
+    out->field("index of stored item ",mData.readUnsignedInt());
   }
   else
   {
@@ -913,7 +952,7 @@ void describeObject(BitByBitData &mData)
     switch(type)
     {
       case PRC_TYPE_ROOT:
-        cout << getIndent() << "NULL Object" << endl;
+        out->note("NULL Object");
         break;
       // topological items
       case PRC_TYPE_TOPO_Connex:
@@ -1001,69 +1040,66 @@ void describeObject(BitByBitData &mData)
       case PRC_TYPE_SURF_Torus:
       case PRC_TYPE_SURF_Transform:
       case PRC_TYPE_SURF_Blend04:
-        cout << getIndent() << "TODO: Unhandled object of type "
-            << type << endl;
+        out->field("TODO: Unhandled object of type ",type);
         break;
       default:
-        cout << getIndent() << "Invalid object of type " << type << endl;
+        out->field("Invalid object of type ",type);
         break;
     }
   }
 }
 
-void describeBaseTopology(BitByBitData &mData)
+void PRCDescriber::describeBaseTopology(BitByBitData &mData)
 {
   bool base_information = mData.readBit();
-  cout << getIndent() << "base_information " <<
-      (base_information?"yes":"no") << endl;
+  out->flag("base_information ",base_information);
   if(base_information)
   {
     describeAttributes(mData);
     describeName(mData);
-    cout << getIndent() << "identifier " << mData.readUnsignedInt() << endl;
+    out->field("identifier ",mData.readUnsignedInt());
   }
 }
 
-void describeBaseGeometry(BitByBitData &mData)
+void PRCDescriber::describeBaseGeometry(BitByBitData &mData)
 {
   bool base_information = mData.readBit();
-  cout << getIndent() << "base_information " <<
-      (base_information?"yes":"no") << endl;
+  out->flag("base_information ",base_information);
   if(base_information)
   {
     describeAttributes(mData);
     describeName(mData);
-    cout << getIndent() << "identifier " << mData.readUnsignedInt() << endl;
+    out->field("identifier ",mData.readUnsignedInt());
   }
 }
 
-unsigned int describeContentBody(BitByBitData &mData)
+unsigned int PRCDescriber::describeContentBody(BitByBitData &mData)
 {
   describeBaseTopology(mData);
   unsigned int behaviour = static_cast<unsigned int>(mData.readChar());
-  cout << getIndent() << "behaviour " << behaviour << endl;
+  out->field("behaviour ",behaviour);
   return behaviour;
 }
 
-void describeContentSurface(BitByBitData &mData)
+void PRCDescriber::describeContentSurface(BitByBitData &mData)
 {
   describeBaseGeometry(mData);
-  cout << getIndent() << "extend_info " << mData.readUnsignedInt() << endl;
+  out->field("extend_info ",mData.readUnsignedInt());
 }
 
-void describeBody(BitByBitData &mData)
+void PRCDescriber::describeBody(BitByBitData &mData)
 {
-  cout << getIndent() << "--Body--" << endl;
+  EntityScope scope(out,"Body");
   unsigned int type = mData.readUnsignedInt();
   switch(type)
   {
     case PRC_TYPE_TOPO_BrepData:
     {
-      cout << getIndent() << "--PRC_TYPE_TOPO_BrepData--" << endl;
+      EntityScope scope(out,"PRC_TYPE_TOPO_BrepData");
       unsigned int behaviour = describeContentBody(mData);
 
       unsigned int number_of_connex = mData.readUnsignedInt();
-      cout << getIndent() << "number_of_connex " << number_of_connex << endl;
+      out->field("number_of_connex ",number_of_connex);
       indent();
       for(unsigned int i = 0; i < number_of_connex; ++i)
       {
@@ -1072,7 +1108,7 @@ void describeBody(BitByBitData &mData)
       dedent();
       if(behaviour != 0)
       {
-        cout << getIndent() << "bbox " << endl;
+        out->note("bbox ");
         indent();
         describeExtent3d(mData);
         dedent();
@@ -1081,7 +1117,7 @@ void describeBody(BitByBitData &mData)
     }
     case PRC_TYPE_TOPO_SingleWireBody:
     {
-      cout << getIndent() << "--PRC_TYPE_TOPO_SingleWireBody--" << endl;
+      EntityScope scope(out,"PRC_TYPE_TOPO_SingleWireBody");
       // unsigned int behaviour = describeContentBody(mData);
       // TODO: is behaviour needed to get data about how to describe?
       describeContentBody(mData);
@@ -1092,86 +1128,76 @@ void describeBody(BitByBitData &mData)
     } 
     case PRC_TYPE_TOPO_BrepDataCompress:
     case PRC_TYPE_TOPO_SingleWireBodyCompress:
-      cout << getIndent() << "TODO: Unhandled body type " << type << endl;
+      out->field("TODO: Unhandled body type ",type);
       break;
     default:
-      cout << getIndent() << "Invalid body type " << type << endl;
+      out->field("Invalid body type ",type);
       break;
   }
 }
 
-void describeTopoContext(BitByBitData &mData)
+void PRCDescriber::describeTopoContext(BitByBitData &mData)
 {
-  cout << getIndent() << "--Topological Context--" << endl;
+  EntityScope scope(out,"Topological Context");
   if(!checkSectionCode(mData,PRC_TYPE_TOPO_Context))
     return;
   indent();
 
   describeContentPRCBase(mData,false);
 
-  cout << getIndent() << "behaviour "
-      << static_cast<unsigned int>(mData.readChar()) << endl;
-  cout << getIndent() << "granularity " << mData.readDouble() << endl;
-  cout << getIndent() << "tolerance " << mData.readDouble() << endl;
+  out->field("behaviour ",static_cast<unsigned int>(mData.readChar()));
+  out->field("granularity ",mData.readDouble());
+  out->field("tolerance ",mData.readDouble());
 
   bool have_smallest_face_thickness = mData.readBit();
-  cout << getIndent() << "have_smallest_face_thickness "
-      << (have_smallest_face_thickness?"yes":"no") << endl;
+  out->flag("have_smallest_face_thickness ",have_smallest_face_thickness);
   if(have_smallest_face_thickness)
-    cout << getIndent() << "smallest_thickness " << mData.readDouble() << endl;
+    out->field("smallest_thickness ",mData.readDouble());
 
   bool have_scale = mData.readBit();
-  cout << getIndent() << "have_scale " << (have_scale?"yes":"no") << endl;
+  out->flag("have_scale ",have_scale);
   if(have_scale)
-    cout << getIndent() << "scale " << mData.readDouble() << endl;
+    out->field("scale ",mData.readDouble());
 
   dedent();
 }
 
-void describeLineAttr(BitByBitData& mData)
+void PRCDescriber::describeLineAttr(BitByBitData& mData)
 {
-  cout << getIndent() << "index_of_line_style "
-      << mData.readUnsignedInt()-1 << endl;
+  out->field("index_of_line_style ",mData.readUnsignedInt()-1);
 }
 
-void describeArrayRGBA(BitByBitData& mData, int number_of_colours,
+void PRCDescriber::describeArrayRGBA(BitByBitData& mData, int number_of_colours,
                        int number_by_vector)
 {
   // bool new_colour = true; // not currently used
   for(int i = 0; i < number_by_vector; ++i)
   {
-    cout << getIndent() << static_cast<unsigned int>(mData.readChar()) << ' ';
-    cout << static_cast<unsigned int>(mData.readChar()) << ' ';
-    cout << static_cast<unsigned int>(mData.readChar()) << endl;
+    unsigned int rgb[3];
+    for(int j = 0; j < 3; ++j)
+      rgb[j] = static_cast<unsigned int>(mData.readChar());
+    out->row(rgb,3);
     //TODO: finish this
   }
 }
 
-void describeContentBaseTessData(BitByBitData &mData)
+void PRCDescriber::describeContentBaseTessData(BitByBitData &mData)
 {
-  cout << getIndent() << "is_calculated "
-      << (mData.readBit()?"yes":"no") << endl;
+  out->flag("is_calculated ",mData.readBit());
   unsigned int number_of_coordinates = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_coordinates "
-      << number_of_coordinates << endl;
-  indent();
-  for(unsigned int i = 0; i < number_of_coordinates; ++i)
-  {
-    cout << getIndent() << mData.readDouble() << endl;
-  }
-  dedent();
+  out->field("number_of_coordinates ",number_of_coordinates);
+  describeDoubles(mData,"coordinates",number_of_coordinates);
 }
 
-void describeTessFace(BitByBitData &mData)
+void PRCDescriber::describeTessFace(BitByBitData &mData)
 {
-  cout << getIndent() << "--Tessellation Face--" << endl;
+  EntityScope scope(out,"Tessellation Face");
   if(!checkSectionCode(mData,PRC_TYPE_TESS_Face))
     return;
   indent();
 
   unsigned int size_of_line_attributes = mData.readUnsignedInt();
-  cout << getIndent() << "size_of_line_attributes "
-      << size_of_line_attributes << endl;
+  out->field("size_of_line_attributes ",size_of_line_attributes);
   indent();
   for(unsigned int i = 0; i < size_of_line_attributes; ++i)
   {
@@ -1180,46 +1206,33 @@ void describeTessFace(BitByBitData &mData)
   dedent();
 
   unsigned int start_wire = mData.readUnsignedInt();
-  cout << getIndent() << "start_wire " << start_wire << endl;
+  out->field("start_wire ",start_wire);
   unsigned int size_of_sizes_wire = mData.readUnsignedInt();
-  cout << getIndent() << "size_of_sizes_wire " << size_of_sizes_wire << endl;
-  indent();
-  for(unsigned int i = 0; i < size_of_sizes_wire; ++i)
-  {
-    cout << getIndent() << mData.readUnsignedInt() << endl;
-  }
-  dedent();
+  out->field("size_of_sizes_wire ",size_of_sizes_wire);
+  describeUnsignedInts(mData,"sizes_wire",size_of_sizes_wire);
 
 
   unsigned int used_entities_flag = mData.readUnsignedInt();
-  cout << getIndent() << "used_entities_flag " << used_entities_flag << endl;
+  out->field("used_entities_flag ",used_entities_flag);
 
   unsigned int start_triangulated = mData.readUnsignedInt();
-  cout << getIndent() << "start_triangulated " << start_triangulated << endl;
+  out->field("start_triangulated ",start_triangulated);
   unsigned int size_of_sizes_triangulated = mData.readUnsignedInt();
-  cout << getIndent() << "size_of_sizes_triangulated "
-      << size_of_sizes_triangulated << endl;
-  indent();
-  for(unsigned int i = 0; i < size_of_sizes_triangulated; ++i)
-  {
-    cout << getIndent() << mData.readUnsignedInt() << endl;
-  }
-  dedent();
+  out->field("size_of_sizes_triangulated ",size_of_sizes_triangulated);
+  describeUnsignedInts(mData,"sizes_triangulated",size_of_sizes_triangulated);
 
-  cout << getIndent() << "number_of_texture_coordinate_indexes "
-      << mData.readUnsignedInt() << endl;
+  out->field("number_of_texture_coordinate_indexes ",mData.readUnsignedInt());
 
   bool has_vertex_colors = mData.readBit();
-  cout << getIndent() << "has_vertex_colors "
-      << (has_vertex_colors?"yes":"no") << endl;
+  out->flag("has_vertex_colors ",has_vertex_colors);
   indent();
   if(has_vertex_colors)
   {
     bool is_rgba = mData.readBit();
-    cout << getIndent() << "is_rgba " << (is_rgba?"yes":"no") << endl;
+    out->flag("is_rgba ",is_rgba);
 
     bool b_optimised = mData.readBit();
-    cout << getIndent() << "b_optimised " << (b_optimised?"yes":"no") << endl;
+    out->flag("b_optimised ",b_optimised);
     if(!b_optimised)
     {
       indent();
@@ -1238,69 +1251,48 @@ void describeTessFace(BitByBitData &mData)
 
   if(size_of_line_attributes)
   {
-    cout << getIndent() << "behaviour " << mData.readUnsignedInt() << endl;
+    out->field("behaviour ",mData.readUnsignedInt());
   }
 
   dedent();
 }
 
-void describe3DTess(BitByBitData &mData)
+void PRCDescriber::describe3DTess(BitByBitData &mData)
 {
-  cout << getIndent() << "--3D Tessellation--" << endl;
+  EntityScope scope(out,"3D Tessellation");
   indent();
 
   describeContentBaseTessData(mData);
 
-  cout << getIndent() << "has_faces " << (mData.readBit()?"yes":"no") << endl;
-  cout << getIndent() << "has_loops " << (mData.readBit()?"yes":"no") << endl;
+  out->flag("has_faces ",mData.readBit());
+  out->flag("has_loops ",mData.readBit());
 
   bool must_recalculate_normals = mData.readBit();
-  cout << getIndent() << "must_recalculate_normals "
-      << (must_recalculate_normals?"yes":"no") << endl;
+  out->flag("must_recalculate_normals ",must_recalculate_normals);
   indent();
   if(must_recalculate_normals)
   {
-    cout << getIndent()
-        << "Docs were wrong: must_recalculate_normals is true." << endl;
-    cout << getIndent() << "normals_recalculation_flags "
-        << static_cast<unsigned int>(mData.readChar()) << endl;
-    cout << getIndent() << "crease_angle " << mData.readDouble() << endl;
+    out->note("Docs were wrong: must_recalculate_normals is true.");
+    out->field("normals_recalculation_flags ",
+        static_cast<unsigned int>(mData.readChar()));
+    out->field("crease_angle ",mData.readDouble());
   }
   dedent();
 
   unsigned int number_of_normal_coordinates = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_normal_coordinates "
-      << number_of_normal_coordinates << endl;
-  indent();
-  for(unsigned int i = 0; i < number_of_normal_coordinates; ++i)
-  {
-    cout << getIndent() << mData.readDouble() << endl;
-  }
-  dedent();
+  out->field("number_of_normal_coordinates ",number_of_normal_coordinates);
+  describeDoubles(mData,"normal_coordinates",number_of_normal_coordinates);
 
   unsigned int number_of_wire_indices = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_wire_indices "
-      << number_of_wire_indices << endl;
-  indent();
-  for(unsigned int i = 0; i < number_of_wire_indices; ++i)
-  {
-    cout << getIndent() << mData.readUnsignedInt() << endl;
-  }
-  dedent();
+  out->field("number_of_wire_indices ",number_of_wire_indices);
+  describeUnsignedInts(mData,"wire_indices",number_of_wire_indices);
 
   unsigned int number_of_triangulated_indices = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_triangulated_indices "
-      << number_of_triangulated_indices << endl;
-  indent();
-  for(unsigned int i = 0; i < number_of_triangulated_indices; ++i)
-  {
-    cout << getIndent() << mData.readUnsignedInt() << endl;
-  }
-  dedent();
+  out->field("number_of_triangulated_indices ",number_of_triangulated_indices);
+  describeUnsignedInts(mData,"triangulated_indices",number_of_triangulated_indices);
 
   unsigned int number_of_face_tessellation = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_face_tessellation "
-      << number_of_face_tessellation << endl;
+  out->field("number_of_face_tessellation ",number_of_face_tessellation);
   indent();
   for(unsigned int i = 0; i < number_of_face_tessellation; ++i)
   {
@@ -1309,45 +1301,42 @@ void describe3DTess(BitByBitData &mData)
   dedent();
 
   unsigned int number_of_texture_coordinates = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_texture_coordinates "
-      << number_of_texture_coordinates << endl;
-  indent();
-  for(unsigned int i = 0; i < number_of_texture_coordinates; ++i)
-  {
-    cout << getIndent() << mData.readDouble() << endl;
-  }
-  dedent();
+  out->field("number_of_texture_coordinates ",number_of_texture_coordinates);
+  describeDoubles(mData,"texture_coordinates",number_of_texture_coordinates);
 
   dedent();
 }
 
-void describe3DWireTess(BitByBitData &mData)
+void PRCDescriber::describe3DWireTess(BitByBitData &mData)
 {
   //TODO
 }
 
-void describe3DMarkupTess(BitByBitData &mData)
+void PRCDescriber::describe3DMarkupTess(BitByBitData &mData)
 {
   //TODO
 }
 
-void describeHighlyCompressed3DTess(BitByBitData &mData)
+void PRCDescriber::describeHighlyCompressed3DTess(BitByBitData &mData)
 {
   //TODO
+  // without the layout of the compressed data its end is unknown, so
+  // nothing that follows it can be described correctly
+  out->note("Highly compressed tessellation is not described, the data after it is not aligned.");
 }
 
-void describeSceneDisplayParameters(BitByBitData &mData)
+void PRCDescriber::describeSceneDisplayParameters(BitByBitData &mData)
 {
-  cout << getIndent() << "--Scene Display Parameters--" << endl;
+  EntityScope scope(out,"Scene Display Parameters");
   if(!checkSectionCode(mData,PRC_TYPE_GRAPH_SceneDisplayParameters))
     return;
   indent();
   describeContentPRCBase(mData,true);
 
-  cout << getIndent() << "is active? " << (mData.readBit()?"yes":"no") << endl;
+  out->flag("is active? ",mData.readBit());
 
   unsigned int number_of_lights = mData.readUnsignedInt();
-  cout << getIndent() << "number of lights " << number_of_lights << endl;
+  out->field("number of lights ",number_of_lights);
   indent();
   for(unsigned int i = 0; i < number_of_lights; ++i)
   {
@@ -1356,233 +1345,219 @@ void describeSceneDisplayParameters(BitByBitData &mData)
   dedent();
 
   bool camera = mData.readBit();
-  cout << getIndent() << "camera? " << (camera?"yes":"no") << endl;
+  out->flag("camera? ",camera);
   if(camera)
     describeCamera(mData);
 
   bool rotation_centre = mData.readBit();
-  cout << getIndent() << "rotation centre? " << (rotation_centre?"yes":"no") << endl;
+  out->flag("rotation centre? ",rotation_centre);
   if(rotation_centre)
     describeVector3d(mData);
 
   unsigned int number_of_clipping_planes = mData.readUnsignedInt();
-  cout << getIndent() << "number of clipping planes " << number_of_clipping_planes << endl;
+  out->field("number of clipping planes ",number_of_clipping_planes);
   indent();
   for(unsigned int i = 0; i < number_of_clipping_planes; ++i)
   {
-    cout << "Can't describe planes!!!" << endl;
+    out->warning("Can't describe planes!!!");
     //describePlane(mData);
   }
   dedent();
 
-  cout << getIndent() << "Background line style index: " << mData.readUnsignedInt()-1 << endl;
-  cout << getIndent() << "Default line style index: " << mData.readUnsignedInt()-1 << endl;
+  out->field("Background line style index: ",mData.readUnsignedInt()-1);
+  out->field("Default line style index: ",mData.readUnsignedInt()-1);
 
   unsigned int number_of_default_styles_per_type = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_default_styles_per_type " << number_of_default_styles_per_type << endl;
+  out->field("number_of_default_styles_per_type ",
+      number_of_default_styles_per_type);
   indent();
   for(unsigned int i = 0; i < number_of_default_styles_per_type; ++i)
   {
-    cout << getIndent() << "type " << mData.readUnsignedInt() << endl;
-    cout << getIndent() << "line style index: " << mData.readUnsignedInt()-1 << endl;
+    out->field("type ",mData.readUnsignedInt());
+    out->field("line style index: ",mData.readUnsignedInt()-1);
   }
   dedent();
 
   dedent();
 }
 
-void describeCartesionTransformation3d(BitByBitData& mData)
+void PRCDescriber::describeCartesionTransformation3d(BitByBitData& mData)
 {
-  cout << getIndent() << "--3d Cartesian Transformation--" << endl;
+  EntityScope scope(out,"3d Cartesian Transformation");
   if(!checkSectionCode(mData,PRC_TYPE_MISC_CartesianTransformation))
     return;
   indent();
   unsigned char behaviour = mData.readChar();
-  cout << getIndent() << "behaviour "
-      << static_cast<unsigned int>(behaviour) << endl;
+  out->field("behaviour ",static_cast<unsigned int>(behaviour));
   if((behaviour & PRC_TRANSFORMATION_Translate) != 0)
   {
-    cout << getIndent() << "Translation" << endl;
+    out->note("Translation");
     describeVector3d(mData);
   }
 
   if((behaviour & PRC_TRANSFORMATION_NonOrtho) != 0)
   {
-    cout << getIndent() << "Non orthogonal transformation" << endl;
-    cout << getIndent() << "X" << endl; describeVector3d(mData);
-    cout << getIndent() << "Y" << endl; describeVector3d(mData);
-    cout << getIndent() << "Z" << endl; describeVector3d(mData);
+    out->note("Non orthogonal transformation");
+    out->note("X"); describeVector3d(mData);
+    out->note("Y"); describeVector3d(mData);
+    out->note("Z"); describeVector3d(mData);
   }
   else if((behaviour & PRC_TRANSFORMATION_Rotate) != 0)
   {
-    cout << getIndent() << "Rotation" << endl;
-    cout << getIndent() << "X" << endl; describeVector3d(mData);
-    cout << getIndent() << "Y" << endl; describeVector3d(mData);
+    out->note("Rotation");
+    out->note("X"); describeVector3d(mData);
+    out->note("Y"); describeVector3d(mData);
   }
 
   // this is different from the docs!!! but it works...
   if ((behaviour & PRC_TRANSFORMATION_NonUniformScale) != 0)
   {
-    cout << getIndent() << "Non-uniform scale by " << endl;
+    out->note("Non-uniform scale by ");
     describeVector3d(mData);
   }
 
   // this is different from the docs!!! but it works...
   if((behaviour & PRC_TRANSFORMATION_Scale) != 0)
   {
-    cout << getIndent() << "Uniform Scale by " << mData.readDouble() << endl;
+    out->field("Uniform Scale by ",mData.readDouble());
   }
 
   if((behaviour & PRC_TRANSFORMATION_Homogeneous) != 0)
   {
-    cout << getIndent() << "transformation has homogenous values" << endl;
-    cout << getIndent() << "x = " << mData.readDouble() << endl;
-    cout << getIndent() << "y = " << mData.readDouble() << endl;
-    cout << getIndent() << "z = " << mData.readDouble() << endl;
-    cout << getIndent() << "w = " << mData.readDouble() << endl;
+    out->note("transformation has homogenous values");
+    out->field("x = ",mData.readDouble());
+    out->field("y = ",mData.readDouble());
+    out->field("z = ",mData.readDouble());
+    out->field("w = ",mData.readDouble());
   }
   dedent();
 }
 
-void describeTransformation3d(BitByBitData& mData)
+void PRCDescriber::describeTransformation3d(BitByBitData& mData)
 {
-  cout << getIndent() << "--3d Transformation--" << endl;
+  EntityScope scope(out,"3d Transformation");
   indent();
   bool has_transformation = mData.readBit();
-  cout << getIndent() << "has_transformation "
-      << (has_transformation?"yes":"no") << endl;
+  out->flag("has_transformation ",has_transformation);
   if(has_transformation)
   {
     unsigned char behaviour = mData.readChar();
-    cout << getIndent() << "behaviour "
-        << static_cast<unsigned int>(behaviour) << endl;
+    out->field("behaviour ",static_cast<unsigned int>(behaviour));
     if((behaviour & PRC_TRANSFORMATION_Translate) != 0)
     {
-      cout << getIndent() << "Translation" << endl;
+      out->note("Translation");
       describeVector3d(mData);
     }
     if((behaviour & PRC_TRANSFORMATION_Rotate) != 0)
     {
-      cout << getIndent() << "Rotation" << endl;
-      cout << getIndent() << "X" << endl; describeVector3d(mData);
-      cout << getIndent() << "Y" << endl; describeVector3d(mData);
+      out->note("Rotation");
+      out->note("X"); describeVector3d(mData);
+      out->note("Y"); describeVector3d(mData);
     }
 
     if((behaviour & PRC_TRANSFORMATION_Scale) != 0)
     {
-      cout << getIndent() << "Uniform Scale by " << mData.readDouble() << endl;
+      out->field("Uniform Scale by ",mData.readDouble());
     }
   }
   dedent();
 }
 
-void describeTransformation2d(BitByBitData& mData)
+void PRCDescriber::describeTransformation2d(BitByBitData& mData)
 {
-  cout << getIndent() << "--2d Transformation--" << endl;
+  EntityScope scope(out,"2d Transformation");
   indent();
   bool has_transformation = mData.readBit();
-  cout << "has_transformation " << (has_transformation?"yes":"no") << endl;
+  out->unindentedFlag("has_transformation ",has_transformation);
   if(has_transformation)
   {
     unsigned char behaviour = mData.readChar();
-    cout << getIndent() << "behaviour "
-        << static_cast<unsigned int>(behaviour) << endl;
+    out->field("behaviour ",static_cast<unsigned int>(behaviour));
     if((behaviour & PRC_TRANSFORMATION_Translate) != 0)
     {
-      cout << getIndent() << "Translation" << endl;
+      out->note("Translation");
       describeVector2d(mData);
     }
     if((behaviour & PRC_TRANSFORMATION_Rotate) != 0)
     {
-      cout << getIndent() << "Rotation" << endl;
-      cout << getIndent() << "X" << endl; describeVector2d(mData);
-      cout << getIndent() << "Y" << endl; describeVector2d(mData);
+      out->note("Rotation");
+      out->note("X"); describeVector2d(mData);
+      out->note("Y"); describeVector2d(mData);
     }
 
     if((behaviour & PRC_TRANSFORMATION_Scale) != 0)
     {
-      cout << getIndent() << "Uniform Scale by " << mData.readDouble() << endl;
+      out->field("Uniform Scale by ",mData.readDouble());
     }
   }
   dedent();
 }
 
-void describeFileStructureInternalData(BitByBitData &mData)
+void PRCDescriber::describeFileStructureInternalData(BitByBitData &mData)
 {
-  cout << getIndent() << "--File Structure Internal Data--" << endl;
+  EntityScope scope(out,"File Structure Internal Data");
   if(!checkSectionCode(mData,PRC_TYPE_ASM_FileStructure))
     return;
   indent();
   describeContentPRCBase(mData,false);
-  cout << getIndent() << "next_available_index "
-      << mData.readUnsignedInt() << endl;
-  cout << getIndent() << "index_product_occurence "
-      << mData.readUnsignedInt() << endl;
+  out->field("next_available_index ",mData.readUnsignedInt());
+  out->field("index_product_occurence ",mData.readUnsignedInt());
   dedent();
 }
 
-void describeProductOccurrence(BitByBitData &mData)
+void PRCDescriber::describeProductOccurrence(BitByBitData &mData)
 {
-  cout << getIndent() << "--Product Occurrence--" << endl;
+  EntityScope scope(out,"Product Occurrence");
   if(!checkSectionCode(mData,PRC_TYPE_ASM_ProductOccurence))
     return;
   indent();
 
   describeContentPRCBaseWithGraphics(mData,true);
 
-  cout << getIndent() << "index_part "
-      << static_cast<int>(mData.readUnsignedInt()-1) << endl;
+  out->field("index_part ",static_cast<int>(mData.readUnsignedInt()-1));
   unsigned int index_prototype = mData.readUnsignedInt()-1;
-  cout << getIndent() << "index_prototype "
-      << static_cast<int>(index_prototype) << endl;
+  out->field("index_prototype ",static_cast<int>(index_prototype));
   if(index_prototype+1 != 0)
   {
     bool prototype_in_same_file_structure = mData.readBit();
-    cout << getIndent() << "prototype_in_same_file_structure "
-        << (prototype_in_same_file_structure?"yes":"no") << endl;
+    out->flag("prototype_in_same_file_structure ",
+        prototype_in_same_file_structure);
     if(!prototype_in_same_file_structure)
       describeCompressedUniqueID(mData);
   }
 
   unsigned int index_external_data = mData.readUnsignedInt()-1;
-  cout << getIndent() << "index_external_data "
-      << static_cast<int>(index_external_data) << endl;
+  out->field("index_external_data ",static_cast<int>(index_external_data));
   if(index_external_data+1 != 0)
   {
     bool external_data_in_same_file_structure = mData.readBit();
-    cout << getIndent() << "external_data_in_same_file_structure "
-        << (external_data_in_same_file_structure?"yes":"no") << endl;
+    out->flag("external_data_in_same_file_structure ",
+        external_data_in_same_file_structure);
     if(!external_data_in_same_file_structure)
       describeCompressedUniqueID(mData);
   }
 
   unsigned int number_of_son_product_occurences = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_son_product_occurences "
-      << number_of_son_product_occurences << endl;
-  indent();
-  for(unsigned int i = 0; i < number_of_son_product_occurences; ++i)
-    cout << getIndent() << mData.readUnsignedInt() << endl;
-  dedent();
+  out->field("number_of_son_product_occurences ",
+      number_of_son_product_occurences);
+  describeUnsignedInts(mData,"son_product_occurences",number_of_son_product_occurences);
 
-  cout << getIndent() << "product_behaviour "
-      << static_cast<unsigned int>(mData.readChar()) << endl;
+  out->field("product_behaviour ",static_cast<unsigned int>(mData.readChar()));
 
   describeUnit(mData);
-  cout << getIndent() << "Product information flags "
-      << static_cast<unsigned int>(mData.readChar()) << endl;
-  cout << getIndent() << "product_load_status "
-      << mData.readUnsignedInt() << endl;
+  out->field("Product information flags ",
+      static_cast<unsigned int>(mData.readChar()));
+  out->field("product_load_status ",mData.readUnsignedInt());
 
   bool has_location = mData.readBit();
-  cout << getIndent() << "has_location " << has_location << endl;
+  out->field("has_location ",has_location);
   if(has_location)
   {
     describeCartesionTransformation3d(mData);
   }
 
   unsigned int number_of_references = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_references "
-      << number_of_references << endl;
+  out->field("number_of_references ",number_of_references);
   indent();
   for(unsigned int i = 0; i < number_of_references; ++i)
   {
@@ -1593,7 +1568,7 @@ void describeProductOccurrence(BitByBitData &mData)
   describeMarkups(mData);
 
   unsigned int number_of_views = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_views " << number_of_views << endl;
+  out->field("number_of_views ",number_of_views);
   indent();
   for(unsigned int i = 0; i < number_of_views; ++i)
   {
@@ -1602,16 +1577,14 @@ void describeProductOccurrence(BitByBitData &mData)
   dedent();
 
   bool has_entity_filter = mData.readBit();
-  cout << getIndent() << "has_entity_filter "
-      << (has_entity_filter?"yes":"no") << endl;
+  out->flag("has_entity_filter ",has_entity_filter);
   if(has_entity_filter)
   {
     //TODO: describeEntityFilter(mData);
   }
 
   unsigned int number_of_display_filters = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_display_filters "
-      << number_of_display_filters << endl;
+  out->field("number_of_display_filters ",number_of_display_filters);
   indent();
   for(unsigned int i = 0; i < number_of_display_filters; ++i)
   {
@@ -1620,8 +1593,8 @@ void describeProductOccurrence(BitByBitData &mData)
   dedent();
 
   unsigned int number_of_scene_display_parameters = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_scene_display_parameters "
-      << number_of_scene_display_parameters << endl;
+  out->field("number_of_scene_display_parameters ",
+      number_of_scene_display_parameters);
   indent();
   for(unsigned int i = 0; i < number_of_scene_display_parameters; ++i)
   {
@@ -1633,35 +1606,32 @@ void describeProductOccurrence(BitByBitData &mData)
   dedent();
 }
 
-void describeGraphics(BitByBitData &mData)
+void PRCDescriber::describeGraphics(BitByBitData &mData)
 {
   bool sameGraphicsAsCurrent = mData.readBit();
-  cout << getIndent() << "Same graphics as current graphics? "
-      << (sameGraphicsAsCurrent?"yes":"no") << endl;
+  out->flag("Same graphics as current graphics? ",sameGraphicsAsCurrent);
   if(!sameGraphicsAsCurrent)
   {
     layer_index = mData.readUnsignedInt()-1;
-    cout << getIndent() << "layer_index " << layer_index << endl;
+    out->field("layer_index ",layer_index);
     index_of_line_style = mData.readUnsignedInt()-1;
-    cout << getIndent() << "index_of_line_style "
-        << index_of_line_style << endl;
+    out->field("index_of_line_style ",index_of_line_style);
     unsigned char c1 = mData.readChar();
     unsigned char c2 = mData.readChar();
     behaviour_bit_field = c1 | (static_cast<unsigned short>(c2) << 8);
-    cout << getIndent() << "behaviour_bit_field "
-        << behaviour_bit_field << endl;
+    out->field("behaviour_bit_field ",behaviour_bit_field);
   }
 }
 
-void describeContentPRCBaseWithGraphics(BitByBitData &mData, bool efr)
+void PRCDescriber::describeContentPRCBaseWithGraphics(BitByBitData &mData, bool efr)
 {
   describeContentPRCBase(mData,efr);
   describeGraphics(mData);
 }
 
-void describePartDefinition(BitByBitData &mData)
+void PRCDescriber::describePartDefinition(BitByBitData &mData)
 {
-  cout << getIndent() << "--Part Definition--" << endl;
+  EntityScope scope(out,"Part Definition");
   if(!checkSectionCode(mData,PRC_TYPE_ASM_PartDefinition))
     return;
   indent();
@@ -1670,8 +1640,7 @@ void describePartDefinition(BitByBitData &mData)
   describeExtent3d(mData);
 
   unsigned int number_of_representation_items = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_representation_items "
-      << number_of_representation_items << endl;
+  out->field("number_of_representation_items ",number_of_representation_items);
   indent();
   for(unsigned int i = 0; i < number_of_representation_items; ++i)
   {
@@ -1682,7 +1651,7 @@ void describePartDefinition(BitByBitData &mData)
   describeMarkups(mData);
 
   unsigned int number_of_views = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_views " << number_of_views << endl;
+  out->field("number_of_views ",number_of_views);
   indent();
   for(unsigned int i = 0; i < number_of_views; ++i)
   {
@@ -1694,47 +1663,45 @@ void describePartDefinition(BitByBitData &mData)
   dedent();
 }
 
-void describeMarkups(BitByBitData& mData)
+void PRCDescriber::describeMarkups(BitByBitData& mData)
 {
-  cout << getIndent() << "--Markups--" << endl;
+  EntityScope scope(out,"Markups");
   indent();
 
   unsigned int number_of_linked_items = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_linked_items "
-      << number_of_linked_items << endl;
+  out->field("number_of_linked_items ",number_of_linked_items);
   for(unsigned int i = 0; i < number_of_linked_items; ++i)
   {
-    cout << "describe linked item!" << endl;
+    out->warning("describe linked item!");
   }
 
   unsigned int number_of_leaders = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_leaders " << number_of_leaders << endl;
+  out->field("number_of_leaders ",number_of_leaders);
   for(unsigned int i = 0; i < number_of_leaders; ++i)
   {
-    cout << "describe leader!" << endl;
+    out->warning("describe leader!");
   }
 
   unsigned int number_of_markups = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_markups " << number_of_markups << endl;
+  out->field("number_of_markups ",number_of_markups);
   for(unsigned int i=0; i < number_of_markups; ++i)
   {
-    cout << "describe markup!" << endl;
+    out->warning("describe markup!");
   }
 
   unsigned int number_of_annotation_entities = mData.readUnsignedInt();
-  cout << getIndent() << "number_of_annotation_entities "
-      << number_of_annotation_entities << endl;
+  out->field("number_of_annotation_entities ",number_of_annotation_entities);
   for(unsigned int i=0; i < number_of_annotation_entities; ++i)
   {
-    cout << "describe annotation entity!" << endl;
+    out->warning("describe annotation entity!");
   }
 
   dedent();
 }
 
-void describeAnnotationView(BitByBitData &mData)
+void PRCDescriber::describeAnnotationView(BitByBitData &mData)
 {
-  cout << getIndent() << "--Annotation View--" << endl;
+  EntityScope scope(out,"Annotation View");
   if(!checkSectionCode(mData,PRC_TYPE_MKP_View))
     return;
   indent();
@@ -1754,50 +1721,52 @@ void describeAnnotationView(BitByBitData &mData)
   dedent();
 }
 
-void describeExtent3d(BitByBitData &mData)
+void PRCDescriber::describeExtent3d(BitByBitData &mData)
 { // I suspect the order of min/max should be flipped
-  cout << getIndent() << "Minimum" << endl;
+  out->note("Minimum");
   indent(); describeVector3d(mData); dedent();
-  cout << getIndent() << "Maximum" << endl;
+  out->note("Maximum");
   indent(); describeVector3d(mData); dedent();
 }
 
-void describeExtent1d(BitByBitData &mData)
+void PRCDescriber::describeExtent1d(BitByBitData &mData)
 {
-  cout << getIndent() << "Minimum " << mData.readDouble() << endl;
-  cout << getIndent() << "Maximum " << mData.readDouble() << endl;
+  out->field("Minimum ",mData.readDouble());
+  out->field("Maximum ",mData.readDouble());
 }
 
-void describeExtent2d(BitByBitData &mData)
+void PRCDescriber::describeExtent2d(BitByBitData &mData)
 {
-  cout << getIndent() << "Minimum" << endl;
+  out->note("Minimum");
   indent(); describeVector2d(mData); dedent();
-  cout << getIndent() << "Maximum" << endl;
+  out->note("Maximum");
   indent(); describeVector2d(mData); dedent();
 }
 
-void describeVector3d(BitByBitData &mData)
+void PRCDescriber::describeVector3d(BitByBitData &mData)
 {
-  double x = mData.readDouble();
-  double y = mData.readDouble();
-  double z = mData.readDouble();
-  cout << getIndent() << '(' << x << ',' << y << ',' << z << ')' << endl;
+  double v[3];
+  v[0] = mData.readDouble();
+  v[1] = mData.readDouble();
+  v[2] = mData.readDouble();
+  out->coordinates("",v,3);
 }
 
-void describeVector2d(BitByBitData &mData)
+void PRCDescriber::describeVector2d(BitByBitData &mData)
 {
-  double x = mData.readDouble();
-  double y = mData.readDouble();
-  cout << getIndent() << '(' << x << ',' << y << ')' << endl;
+  double v[2];
+  v[0] = mData.readDouble();
+  v[1] = mData.readDouble();
+  out->coordinates("",v,2);
 }
 
-void describePicture(BitByBitData &mData)
+void PRCDescriber::describePicture(BitByBitData &mData)
 {
-  cout << getIndent() << "--Picture--" << endl;
+  EntityScope scope(out,"Picture");
   unsigned int sectionCode = mData.readUnsignedInt();
   if(sectionCode != PRC_TYPE_GRAPH_Picture)
   {
-    cout << getIndent() << "Invalid section code." << endl;
+    out->note("Invalid section code.");
   }
 
   describeContentPRCBase(mData,false);
@@ -1806,108 +1775,97 @@ void describePicture(BitByBitData &mData)
   switch(format)
   {
     case KEPRCPicture_PNG:
-      cout << getIndent() << "PNG format" << endl;
+      out->note("PNG format");
       break;
     case KEPRCPicture_JPG:
-      cout << getIndent() << "JPG format" << endl;
+      out->note("JPG format");
       break;
     case KEPRCPicture_BITMAP_RGB_BYTE:
-      cout << getIndent() << "gzipped pixel data (see PRC base compression). Each element is a RGB triple. (3 components)" << endl;
+      out->note("gzipped pixel data (see PRC base compression). Each element is a RGB triple. (3 components)");
       break;
     case KEPRCPicture_BITMAP_RGBA_BYTE:
-      cout << getIndent() << "gzipped pixel data (see PRC base compression). Each element is a complete RGBA element. (4 components)" << endl;
+      out->note("gzipped pixel data (see PRC base compression). Each element is a complete RGBA element. (4 components)");
       break;
     case KEPRCPicture_BITMAP_GREY_BYTE:
-      cout << getIndent() << "gzipped pixel data (see PRC base compression). Each element is a single luminance value. (1 components)" << endl;
+      out->note("gzipped pixel data (see PRC base compression). Each element is a single luminance value. (1 components)");
       break;
     case KEPRCPicture_BITMAP_GREYA_BYTE:
-      cout << getIndent() << "gzipped pixel data (see PRC base compression). Each element is a luminance/alpha pair. (2 components)" << endl;
+      out->note("gzipped pixel data (see PRC base compression). Each element is a luminance/alpha pair. (2 components)");
       break;
     default:
-      cout << getIndent() << "Invalid picture format." << endl;
+      out->note("Invalid picture format.");
       break;
   }
-  cout << getIndent() << "uncompressed_file_index "
-      << mData.readUnsignedInt()-1 << endl;
-  cout << getIndent() << "pixel width " << mData.readUnsignedInt() << endl;
-  cout << getIndent() << "pixel height " << mData.readUnsignedInt() << endl;
+  out->field("uncompressed_file_index ",mData.readUnsignedInt()-1);
+  out->field("pixel width ",mData.readUnsignedInt());
+  out->field("pixel height ",mData.readUnsignedInt());
 }
 
-void describeTextureDefinition(BitByBitData &mData)
+void PRCDescriber::describeTextureDefinition(BitByBitData &mData)
 {
-  cout << getIndent() << "--Texture Definition--" << endl;
+  EntityScope scope(out,"Texture Definition");
   if(!checkSectionCode(mData,PRC_TYPE_GRAPH_TextureDefinition))
     return;
   
-  cout << getIndent() << "TODO: Can't describe textures yet." << endl;
+  out->note("TODO: Can't describe textures yet.");
 }
 
-void describeMaterial(BitByBitData &mData)
+void PRCDescriber::describeMaterial(BitByBitData &mData)
 {
-  cout << getIndent() << "--Material--" << endl;
+  EntityScope scope(out,"Material");
   unsigned int code = mData.readUnsignedInt();
   if(code == PRC_TYPE_GRAPH_Material)
   {
     describeContentPRCBase(mData,true);
-    cout << getIndent() << "index of ambient color "
-        << mData.readUnsignedInt() - 1 << endl;
-    cout << getIndent() << "index of diffuse color "
-        << mData.readUnsignedInt() - 1 << endl;
-    cout << getIndent() << "index of emissive color "
-        << mData.readUnsignedInt() - 1 << endl;
-    cout << getIndent() << "index of specular color "
-        << mData.readUnsignedInt() - 1 << endl;
-    cout << getIndent() << "shininess " << mData.readDouble() << endl;
-    cout << getIndent() << "ambient_alpha " << mData.readDouble() << endl;
-    cout << getIndent() << "diffuse_alpha " << mData.readDouble() << endl;
-    cout << getIndent() << "emissive_alpha " << mData.readDouble() << endl;
-    cout << getIndent() << "specular_alpha " << mData.readDouble() << endl;
+    out->field("index of ambient color ",mData.readUnsignedInt() - 1);
+    out->field("index of diffuse color ",mData.readUnsignedInt() - 1);
+    out->field("index of emissive color ",mData.readUnsignedInt() - 1);
+    out->field("index of specular color ",mData.readUnsignedInt() - 1);
+    out->field("shininess ",mData.readDouble());
+    out->field("ambient_alpha ",mData.readDouble());
+    out->field("diffuse_alpha ",mData.readDouble());
+    out->field("emissive_alpha ",mData.readDouble());
+    out->field("specular_alpha ",mData.readDouble());
   }
   else if(code == PRC_TYPE_GRAPH_TextureApplication)
   {
     describeContentPRCBase(mData,true);
-    cout << getIndent() << "material_generic_index "
-        << mData.readUnsignedInt() - 1 << endl;
-    cout << getIndent() << "texture_definition_index "
-        << mData.readUnsignedInt() - 1 << endl;
-    cout << getIndent() << "next_texture_index "
-        << mData.readUnsignedInt() - 1 << endl;
-    cout << getIndent() << "UV_coordinates_index "
-        << mData.readUnsignedInt() - 1 << endl;
+    out->field("material_generic_index ",mData.readUnsignedInt() - 1);
+    out->field("texture_definition_index ",mData.readUnsignedInt() - 1);
+    out->field("next_texture_index ",mData.readUnsignedInt() - 1);
+    out->field("UV_coordinates_index ",mData.readUnsignedInt() - 1);
   }
   else
   {
-    cout << getIndent() << "Invalid section code in material definition."
-        << endl;
+    out->note("Invalid section code in material definition.");
   }
 }
 
-void describeLinePattern(BitByBitData &mData)
+void PRCDescriber::describeLinePattern(BitByBitData &mData)
 {
-  cout << getIndent() << "--Line Pattern--" << endl;
+  EntityScope scope(out,"Line Pattern");
   if(!checkSectionCode(mData,PRC_TYPE_GRAPH_LinePattern))
     return;
   indent();
 
   describeContentPRCBase(mData,true);
   unsigned int size_lengths = mData.readUnsignedInt();
-  cout << getIndent() << "size_lengths " << size_lengths << endl;
+  out->field("size_lengths ",size_lengths);
   indent();
   for(unsigned int i=0;i<size_lengths;i++)
   {
-    cout << getIndent() << "length " << mData.readDouble() << endl;
+    out->field("length ",mData.readDouble());
   }
   dedent();
-  cout << getIndent() << "phase " << mData.readDouble() << endl;
-  cout << getIndent() << "is real length "
-      << (mData.readBit()?"yes":"no") << endl;
+  out->field("phase ",mData.readDouble());
+  out->flag("is real length ",mData.readBit());
 
   dedent();
 }
 
-void describeCategory1LineStyle(BitByBitData &mData)
+void PRCDescriber::describeCategory1LineStyle(BitByBitData &mData)
 {
-  cout << getIndent() << "--Category 1 Line Style--" << endl;
+  EntityScope scope(out,"Category 1 Line Style");
   if(!checkSectionCode(mData,PRC_TYPE_GRAPH_Style))
     return;
   indent();
@@ -1916,129 +1874,117 @@ void describeCategory1LineStyle(BitByBitData &mData)
   describeContentPRCBase(mData,true); 
 
 
-  cout << getIndent() << "line_width " << mData.readDouble() << " mm" << endl;
+  out->field("line_width ",mData.readDouble()," mm");
 
-  cout << getIndent() << "is_vpicture " << (mData.readBit()?"yes":"no") << endl;
+  out->flag("is_vpicture ",mData.readBit());
 
-  cout << getIndent() << "line_pattern_index/vpicture_index "
-      << static_cast<int>(mData.readUnsignedInt()-1) << endl;
-  cout << getIndent() << "is_material " << (mData.readBit()?"yes":"no") << endl;
-  cout << getIndent() << "color_index / material_index "
-      << static_cast<int>(mData.readUnsignedInt()-1) << endl;
+  out->field("line_pattern_index/vpicture_index ",
+      static_cast<int>(mData.readUnsignedInt()-1));
+  out->flag("is_material ",mData.readBit());
+  out->field("color_index / material_index ",
+      static_cast<int>(mData.readUnsignedInt()-1));
 
   bool is_transparency_defined = mData.readBit();
-  cout << getIndent() << "is_transparency_defined "
-      << (is_transparency_defined?"yes":"no") << endl;
+  out->flag("is_transparency_defined ",is_transparency_defined);
   if(is_transparency_defined)
   {
     indent();
-    cout << getIndent() << "transparency "
-        << static_cast<unsigned int>(mData.readChar()) << endl;
+    out->field("transparency ",static_cast<unsigned int>(mData.readChar()));
     dedent();
   }
 
   bool is_additional_1_defined = mData.readBit();
-  cout << getIndent() << "is_additional_1_defined "
-      << (is_additional_1_defined?"yes":"no") << endl;
+  out->flag("is_additional_1_defined ",is_additional_1_defined);
   if(is_additional_1_defined)
   {
     indent();
-    cout << getIndent() << "additional_1 "
-        << static_cast<unsigned int>(mData.readChar()) << endl;
+    out->field("additional_1 ",static_cast<unsigned int>(mData.readChar()));
     dedent();
   }
 
   bool is_additional_2_defined = mData.readBit();
-  cout << getIndent() << "is_additional_2_defined "
-      << (is_additional_2_defined?"yes":"no") << endl;
+  out->flag("is_additional_2_defined ",is_additional_2_defined);
   if(is_additional_2_defined)
   {
     indent();
-    cout << getIndent() << "additional_2 "
-        << static_cast<unsigned int>(mData.readChar()) << endl;
+    out->field("additional_2 ",static_cast<unsigned int>(mData.readChar()));
     dedent();
   }
 
   bool is_additional_3_defined = mData.readBit();
-  cout << getIndent() << "is_additional_3_defined "
-      << (is_additional_3_defined?"yes":"no") << endl;
+  out->flag("is_additional_3_defined ",is_additional_3_defined);
   if(is_additional_3_defined)
   {
     indent();
-    cout << getIndent() << "additional_3 "
-        << static_cast<unsigned int>(mData.readChar()) << endl;
+    out->field("additional_3 ",static_cast<unsigned int>(mData.readChar()));
     dedent();
   }
   dedent();
 }
 
-void describeFillPattern(BitByBitData &mData)
+void PRCDescriber::describeFillPattern(BitByBitData &mData)
 {
-  cout << getIndent() << "--Fill Pattern--" << endl;
+  EntityScope scope(out,"Fill Pattern");
   unsigned int type = mData.readUnsignedInt();
-  cout << getIndent() << "type " << type << endl;
+  out->field("type ",type);
   switch(type)
   {
     //TODO: actually describe fill patterns
     default:
-      cout << getIndent() << "Invalid fill pattern type " << type << endl;
+      out->field("Invalid fill pattern type ",type);
   }
 }
 
-void describeRepresentationItemContent(BitByBitData &mData)
+void PRCDescriber::describeRepresentationItemContent(BitByBitData &mData)
 {
   describeContentPRCBaseWithGraphics(mData,true);
   unsigned int index_local_coordinate_system = mData.readUnsignedInt()-1;
   unsigned int index_tessellation = mData.readUnsignedInt()-1;
   //cast to int will not be right for big indices
-  cout << getIndent() << "index_local_coordinate_system "
-      << static_cast<int>(index_local_coordinate_system) << endl;
-  cout << getIndent() << "index_tessellation "
-      << static_cast<int>(index_tessellation) << endl;
+  out->field("index_local_coordinate_system ",
+      static_cast<int>(index_local_coordinate_system));
+  out->field("index_tessellation ",static_cast<int>(index_tessellation));
 }
 
-void describeRepresentationItem(BitByBitData &mData)
+void PRCDescriber::describeRepresentationItem(BitByBitData &mData)
 {
-  cout << getIndent() << "--Representation Item--" << endl;
+  EntityScope scope(out,"Representation Item");
   unsigned int type = mData.readUnsignedInt();
   switch(type)
   {
     case PRC_TYPE_RI_Curve:
     {
-      cout << getIndent() << "--PRC_TYPE_RI_Curve--" << endl;
+      EntityScope scope(out,"PRC_TYPE_RI_Curve");
       describeRepresentationItemContent(mData);
       bool has_wire_body = mData.readBit();
       if(has_wire_body)
       {
-        cout << getIndent() << "context_id " << mData.readUnsignedInt() << endl;
-        cout << getIndent() << "body_id " << mData.readUnsignedInt() << endl;
+        out->field("context_id ",mData.readUnsignedInt());
+        out->field("body_id ",mData.readUnsignedInt());
       }
       describeUserData(mData);
       break;
     }
     case PRC_TYPE_RI_PolyBrepModel:
     {
-      cout << getIndent() << "--PRC_TYPE_RI_PolyBrepModel--" << endl;
+      EntityScope scope(out,"PRC_TYPE_RI_PolyBrepModel");
       describeRepresentationItemContent(mData);
-      cout << getIndent() << "is_closed "
-          << (mData.readBit()?"yes":"no") << endl;
+      out->flag("is_closed ",mData.readBit());
       describeUserData(mData);
       break;
     }
     case PRC_TYPE_RI_BrepModel:
     {
-      cout << getIndent() << "--PRC_TYPE_RI_BrepModel--" << endl;
+      EntityScope scope(out,"PRC_TYPE_RI_BrepModel");
       describeRepresentationItemContent(mData);
       bool has_brep_data = mData.readBit();
-      cout << getIndent() << "has_brep_data "
-          << (has_brep_data?"yes":"no") << endl;
+      out->flag("has_brep_data ",has_brep_data);
       if(has_brep_data)
       {
-        cout << getIndent() << "context_id " << mData.readUnsignedInt() << endl;
-        cout << getIndent() << "object_id " << mData.readUnsignedInt() << endl;
+        out->field("context_id ",mData.readUnsignedInt());
+        out->field("object_id ",mData.readUnsignedInt());
       }
-      cout << getIndent() << "is_closed "
-          << (mData.readBit()?"yes":"no") << endl;
+      out->flag("is_closed ",mData.readBit());
       describeUserData(mData);
       break;
     }
@@ -2049,133 +1995,117 @@ void describeRepresentationItem(BitByBitData &mData)
     case PRC_TYPE_RI_PointSet:
     case PRC_TYPE_RI_Set:
     case PRC_TYPE_RI_PolyWire:
-      cout << getIndent() << "TODO: Unhandled representation item "
-          << type << endl;
+      out->field("TODO: Unhandled representation item ",type);
       break;
     default:
-      cout << getIndent() << "Invalid representation item type "
-          << type << endl;
+      out->field("Invalid representation item type ",type);
       break;
   }
 }
 
-void describeRGBColour(BitByBitData &mData)
+void PRCDescriber::describeRGBColour(BitByBitData &mData)
 {
-  cout << getIndent() << "R: " << mData.readDouble();
-  cout << " G: " << mData.readDouble();
-  cout << " B: " << mData.readDouble() << endl;
+  double r = mData.readDouble();
+  double g = mData.readDouble();
+  double b = mData.readDouble();
+  out->colour(r,g,b);
 }
 
-void describeSchema(BitByBitData &mData)
+void PRCDescriber::describeSchema(BitByBitData &mData)
 {
-  cout << getIndent() << "--Schema--" << endl;
+  EntityScope scope(out,"Schema");
   indent();
   unsigned int numSchemas = mData.readUnsignedInt();
-  cout << getIndent() << "Number of Schemas " << numSchemas << endl;
+  out->field("Number of Schemas ",numSchemas);
   if(numSchemas != 0)
   {
-    cout << "Error: Don't know how to handle multiple schemas." << endl;
+    out->warning("Error: Don't know how to handle multiple schemas.");
   }
   dedent();
 }
 
-extern string currentName;
-int layer_index;
-int index_of_line_style;
-unsigned short behaviour_bit_field;
-
-void resetCurrentGraphics()
+void PRCDescriber::resetCurrentGraphics()
 {
   layer_index = -1;
   index_of_line_style = -1;
   behaviour_bit_field = 1;
 }
 
-void unFlushSerialization()
+void PRCDescriber::unFlushSerialization()
 {
   currentName = "";
 
   resetCurrentGraphics();
 }
 
-void describeName(BitByBitData &mData)
+void PRCDescriber::describeName(BitByBitData &mData)
 {
   bool sameNameAsCurrent = mData.readBit();
-  cout << getIndent() << "Same name as current name? "
-      << (sameNameAsCurrent?"yes":"no") << endl;
+  out->flag("Same name as current name? ",sameNameAsCurrent);
   if(!sameNameAsCurrent)
     currentName = mData.readString();
-  cout << getIndent() << "Name \"" << currentName << '\"' << endl;
+  out->text("Name ",currentName);
 }
 
-void describeUnit(BitByBitData &mData)
+void PRCDescriber::describeUnit(BitByBitData &mData)
 {
-  cout << getIndent() << "Unit is from CAD file? "
-      << (mData.readBit()?"yes":"no") << endl;
-  cout << getIndent() << "Unit is " << mData.readDouble() << " mm" << endl;
+  out->flag("Unit is from CAD file? ",mData.readBit());
+  out->field("Unit is ",mData.readDouble()," mm");
 }
 
-void describeAttributes(BitByBitData &mData)
+void PRCDescriber::describeAttributes(BitByBitData &mData)
 {
-  cout << getIndent() << "--Attributes--" << endl;
+  EntityScope scope(out,"Attributes");
   indent();
 
   unsigned int numAttribs = mData.readUnsignedInt();
-  cout << getIndent() << "Number of Attributes " << numAttribs << endl;
+  out->field("Number of Attributes ",numAttribs);
   indent();
   for(unsigned int i = 0; i < numAttribs; ++i)
   {
-    cout << getIndent() << "PRC_TYPE_MISC_Attribute "
-        << mData.readUnsignedInt() << endl;
+    out->field("PRC_TYPE_MISC_Attribute ",mData.readUnsignedInt());
     bool titleIsInt = mData.readBit();
-    cout << getIndent() << "Title is integer? "
-        << (titleIsInt?"yes":"no") << endl;
+    out->flag("Title is integer? ",titleIsInt);
     indent();
     if(titleIsInt)
     {
-      cout << getIndent() << "Title " << mData.readUnsignedInt() << endl;
+      out->field("Title ",mData.readUnsignedInt());
     }
     else
     {
-      cout << getIndent() << "Title \"" << mData.readString() << '\"' << endl;
+      out->text("Title ",mData.readString());
     }
     unsigned int sizeOfAttributeKeys = mData.readUnsignedInt();
-    cout << getIndent() << "Size of Attribute Keys "
-        << sizeOfAttributeKeys << endl;
+    out->field("Size of Attribute Keys ",sizeOfAttributeKeys);
     for(unsigned int a = 0; a < sizeOfAttributeKeys; ++a)
     {
       bool titleIsInt = mData.readBit();
-      cout << getIndent() << "Title is integer? "
-          << (titleIsInt?"yes":"no") << endl;
+      out->flag("Title is integer? ",titleIsInt);
       indent();
       if(titleIsInt)
       {
-        cout << getIndent() << "Title " << mData.readUnsignedInt() << endl;
+        out->field("Title ",mData.readUnsignedInt());
       }
       else
       {
-        cout << getIndent() << "Title \"" << mData.readString() << '\"' << endl;
+        out->text("Title ",mData.readString());
       }
       dedent();
       unsigned int attributeType = mData.readUnsignedInt();
-      cout << getIndent() << "Attribute Type " << attributeType << endl;
+      out->field("Attribute Type ",attributeType);
       switch(attributeType)
       {
         case KEPRCModellerAttributeTypeInt:
-          cout << getIndent() << "Attribute Value (int) "
-              << mData.readInt() << endl;
+          out->field("Attribute Value (int) ",mData.readInt());
           break;
         case KEPRCModellerAttributeTypeReal:
-          cout << getIndent() << "Attribute Value (double) "
-              << mData.readDouble() << endl;
+          out->field("Attribute Value (double) ",mData.readDouble());
           break;
         case KEPRCModellerAttributeTypeTime:
-          cout << getIndent() << "Attribute Value (time_t) "
-              << mData.readUnsignedInt() << endl;
+          out->field("Attribute Value (time_t) ",mData.readUnsignedInt());
           break;
         case KEPRCModellerAttributeTypeString:
-          cout << getIndent() << "Attribute Value (string) \""
-              << mData.readString() << '\"' << endl;
+          out->text("Attribute Value (string) ",mData.readString());
           break;
         default:
           break;
@@ -2183,7 +2113,7 @@ void describeAttributes(BitByBitData &mData)
     }
     dedent();
 
-    cout << endl;
+    out->blankLine();
   }
   dedent();
 
@@ -2191,82 +2121,51 @@ void describeAttributes(BitByBitData &mData)
   dedent();
 }
 
-void describeContentPRCBase(BitByBitData &mData, bool typeEligibleForReference)
+void PRCDescriber::describeContentPRCBase(BitByBitData &mData, bool typeEligibleForReference)
 {
-  cout << getIndent() << "--ContentPRCBase--" << endl;
+  EntityScope scope(out,"ContentPRCBase");
   indent();
   describeAttributes(mData);
   describeName(mData);
   if(typeEligibleForReference)
   {
-    cout << getIndent() << "CAD_identifier "
-        << mData.readUnsignedInt() << endl;
-    cout << getIndent() << "CAD_persistent_identifier "
-        << mData.readUnsignedInt() << endl;
-    cout << getIndent() << "PRC_unique_identifier "
-        << mData.readUnsignedInt() << endl;
+    out->field("CAD_identifier ",mData.readUnsignedInt());
+    out->field("CAD_persistent_identifier ",mData.readUnsignedInt());
+    out->field("PRC_unique_identifier ",mData.readUnsignedInt());
   }
   dedent();
 }
 
-void describeCompressedUniqueID(BitByBitData &mData)
+void PRCDescriber::describeCompressedUniqueID(BitByBitData &mData)
 {
-  cout << getIndent() << "UUID: " << hex << setfill('0');
+  unsigned int id[4];
   for(int i = 0; i < 4; ++i)
-    cout << setw(8) << mData.readUnsignedInt() << ' ';
-  cout << dec << setfill(' ') << endl;
+    id[i] = mData.readUnsignedInt();
+  out->uuid("UUID: ",id);
 }
 
-void describeUserData(BitByBitData &mData)
+void PRCDescriber::describeUserData(BitByBitData &mData)
 {
   unsigned int bits = mData.readUnsignedInt();
-  cout << getIndent() << bits << " bits of user data" << endl;
-  indent();
-  for(unsigned int i = 0; i < bits; ++i)
-  {
-    if(i%64 == 0)
-      cout << getIndent();
-    cout << mData.readBit();
-    if(i%64 == 63)
-      cout << endl;
-  }
-  if(bits%64 != 0)
-    cout << endl;
-  dedent();
+  string userData;
+  for(unsigned int i = 0; i < bits && !mData.readFailed(); ++i)
+    userData += mData.readBit() ? '1' : '0';
+  out->userData(userData);
 }
 
-bool checkSectionCode(BitByBitData &mData, unsigned int code)
+bool PRCDescriber::checkSectionCode(BitByBitData &mData, unsigned int code)
 {
   unsigned int num = mData.readUnsignedInt();
-  if(code != num)
-  {
-    cout << getIndent() << "Invalid section code " << num <<
-        ". Expected " << code << " at "; mData.tellPosition();
-    return false;
-  }
-  else
-  {
-    cout << getIndent() << "Section code " << code << endl;
-    return true;
-  }
-}
-
-unsigned int currentIndent = 0;
-
-string getIndent()
-{
-  ostringstream out;
-  for(unsigned int i = 0; i < currentIndent; ++i)
-    out << "  ";
-  return out.str();
+  out->sectionCode(num,code);
+  return num == code;
 }
 
-void indent()
+void PRCDescriber::indent()
 {
-  ++currentIndent;
+  out->indent();
 }
 
-void dedent()
+void PRCDescriber::dedent()
 {
-  --currentIndent;
+  out->dedent();
 }
@@ -23,95 +23,116 @@
 
 #include "iPRCFile.h"
 #include "bitData.h"
+#include "describeEmitter.h"
 
-void describeGlobals(BitByBitData&);
-void describeTree(BitByBitData&);
-void describeTessellation(BitByBitData&);
-void describeGeometry(BitByBitData&);
-void describeExtraGeometry(BitByBitData&);
-void describeModelFileData(BitByBitData&,unsigned int);
+// Decodes PRC sections and reports what it finds to a DescribeEmitter.
+// All decoding state lives in this object, so different sections or
+// files can be described on different threads, one PRCDescriber each.
+class PRCDescriber
+{
+  public:
+    PRCDescriber(DescribeEmitter&);
 
-void describePicture(BitByBitData&);
-void describeTextureDefinition(BitByBitData&);
-void describeMaterial(BitByBitData&);
-void describeLinePattern(BitByBitData&);
-void describeCategory1LineStyle(BitByBitData&);
-void describeFillPattern(BitByBitData&);
-void describeRepresentationItem(BitByBitData&);
+    void describeGlobals(BitByBitData&);
+    void describeTree(BitByBitData&);
+    void describeTessellation(BitByBitData&);
+    void describeGeometry(BitByBitData&);
+    void describeExtraGeometry(BitByBitData&);
+    void describeModelFileData(BitByBitData&,unsigned int);
+    // Describe one entity of a type found in an EntityIndex, starting at
+    // the current position. Names and graphics inherited from earlier
+    // entities are not known. False if entities of this type cannot be
+    // described on their own.
+    bool describeEntity(BitByBitData&,const std::string &type);
 
-//void describe(BitByBitData&);
-void describeLight(BitByBitData&);
-void describeCamera(BitByBitData&);
-bool describeContentCurve(BitByBitData&);
-void describeCurvCircle(BitByBitData&);
-void describeCurvLine(BitByBitData&);
-void describeCurvNURBS(BitByBitData&);
-void describeCurvPolyLine(BitByBitData&);
-void describeContentWireEdge(BitByBitData&);
-bool isCompressedSerialType(unsigned int);
-void describeUVParametrization(BitByBitData&);
-void describeSurfNURBS(BitByBitData&);
-void describeSurfCylinder(BitByBitData&);
-void describeSurfPlane(BitByBitData&);
-void describeTopoFace(BitByBitData&);
-void describeTopoLoop(BitByBitData&);
-void describeTopoCoEdge(BitByBitData&);
-void describeTopoEdge(BitByBitData&);
-void describeTopoConnex(BitByBitData&);
-void describeTopoShell(BitByBitData&);
-void describeObject(BitByBitData&);
-void describeBaseTopology(BitByBitData&);
-void describeBaseGeometry(BitByBitData&);
-unsigned int describeContentBody(BitByBitData&);
-void describeContentSurface(BitByBitData&);
-void describeBody(BitByBitData&);
-void describeTopoContext(BitByBitData&);
-void describeLineAttr(BitByBitData&);
-void describeArrayRGBA(BitByBitData&,int,int);
-void describeContentBaseTessData(BitByBitData&);
-void describeTessFace(BitByBitData&);
-void describe3DTess(BitByBitData&);
-void describe3DWireTess(BitByBitData&);
-void describe3DMarkupTess(BitByBitData&);
-void describeHighlyCompressed3DTess(BitByBitData&);
-void describeSceneDisplayParameters(BitByBitData&);
-void describeCartesionTransformation3d(BitByBitData&);
-void describeTransformation3d(BitByBitData&);
-void describeTransformation2d(BitByBitData&);
-void describeFileStructureInternalData(BitByBitData&);
-void describeProductOccurrence(BitByBitData&);
-void describeRepresentationItemContent(BitByBitData&);
-void describeMarkups(BitByBitData&);
-void describeAnnotationView(BitByBitData&);
-void describeExtent3d(BitByBitData&);
-void describeExtent2d(BitByBitData&);
-void describeExtent1d(BitByBitData&);
-void describeVector3d(BitByBitData&);
-void describeVector2d(BitByBitData&);
-void describeContentPRCBaseWithGraphics(BitByBitData&,bool);
-void describeGraphics(BitByBitData&);
-void describePartDefinition(BitByBitData&);
-void describeRGBColour(BitByBitData&);
-void describeSchema(BitByBitData&);
-void describeName(BitByBitData&);
-void describeAttributes(BitByBitData&);
-void describeContentPRCBase(BitByBitData&,bool);
-void describeUnit(BitByBitData&);
-void describeCompressedUniqueID(BitByBitData&);
-void describeUserData(BitByBitData&);
+    void describePicture(BitByBitData&);
+    void describeTextureDefinition(BitByBitData&);
+    void describeMaterial(BitByBitData&);
+    void describeLinePattern(BitByBitData&);
+    void describeCategory1LineStyle(BitByBitData&);
+    void describeFillPattern(BitByBitData&);
+    void describeRepresentationItem(BitByBitData&);
 
-extern std::string currentName;
-extern int layer_index;
-extern int index_of_line_style;
-extern unsigned short behaviour_bit_field;
+    //void describe(BitByBitData&);
+    void describeLight(BitByBitData&);
+    void describeCamera(BitByBitData&);
+    bool describeContentCurve(BitByBitData&);
+    void describeCurvCircle(BitByBitData&);
+    void describeCurvLine(BitByBitData&);
+    void describeCurvNURBS(BitByBitData&);
+    void describeCurvPolyLine(BitByBitData&);
+    void describeContentWireEdge(BitByBitData&);
+    static bool isCompressedSerialType(unsigned int);
+    void describeUVParametrization(BitByBitData&);
+    void describeSurfNURBS(BitByBitData&);
+    void describeSurfCylinder(BitByBitData&);
+    void describeSurfPlane(BitByBitData&);
+    void describeTopoFace(BitByBitData&);
+    void describeTopoLoop(BitByBitData&);
+    void describeTopoCoEdge(BitByBitData&);
+    void describeTopoEdge(BitByBitData&);
+    void describeTopoConnex(BitByBitData&);
+    void describeTopoShell(BitByBitData&);
+    void describeObject(BitByBitData&);
+    void describeBaseTopology(BitByBitData&);
+    void describeBaseGeometry(BitByBitData&);
+    unsigned int describeContentBody(BitByBitData&);
+    void describeContentSurface(BitByBitData&);
+    void describeBody(BitByBitData&);
+    void describeTopoContext(BitByBitData&);
+    void describeLineAttr(BitByBitData&);
+    void describeArrayRGBA(BitByBitData&,int,int);
+    void describeContentBaseTessData(BitByBitData&);
+    void describeTessFace(BitByBitData&);
+    void describe3DTess(BitByBitData&);
+    void describe3DWireTess(BitByBitData&);
+    void describe3DMarkupTess(BitByBitData&);
+    void describeHighlyCompressed3DTess(BitByBitData&);
+    void describeSceneDisplayParameters(BitByBitData&);
+    void describeCartesionTransformation3d(BitByBitData&);
+    void describeTransformation3d(BitByBitData&);
+    void describeTransformation2d(BitByBitData&);
+    void describeFileStructureInternalData(BitByBitData&);
+    void describeProductOccurrence(BitByBitData&);
+    void describeRepresentationItemContent(BitByBitData&);
+    void describeMarkups(BitByBitData&);
+    void describeAnnotationView(BitByBitData&);
+    void describeExtent3d(BitByBitData&);
+    void describeExtent2d(BitByBitData&);
+    void describeExtent1d(BitByBitData&);
+    void describeVector3d(BitByBitData&);
+    void describeVector2d(BitByBitData&);
+    void describeContentPRCBaseWithGraphics(BitByBitData&,bool);
+    void describeGraphics(BitByBitData&);
+    void describePartDefinition(BitByBitData&);
+    void describeRGBColour(BitByBitData&);
+    void describeSchema(BitByBitData&);
+    void describeName(BitByBitData&);
+    void describeAttributes(BitByBitData&);
+    void describeContentPRCBase(BitByBitData&,bool);
+    void describeUnit(BitByBitData&);
+    void describeCompressedUniqueID(BitByBitData&);
+    void describeUserData(BitByBitData&);
 
-void unFlushSerialization();
-void resetCurrentGraphics();
+    void unFlushSerialization();
+    void resetCurrentGraphics();
 
-bool checkSectionCode(BitByBitData&,unsigned int);
+    bool checkSectionCode(BitByBitData&,unsigned int);
 
-std::string getIndent();
-void indent();
-void dedent();
+  private:
+    void describeParameterization(BitByBitData&);
+    void describeTopoUniqueVertex(BitByBitData&);
+    void describeDoubles(BitByBitData&,const char*,unsigned int);
+    void describeUnsignedInts(BitByBitData&,const char*,unsigned int);
+
+    void indent();
+    void dedent();
+
+    DescribeEmitter *out;
+    std::string currentName;
+    int layer_index;
+    int index_of_line_style;
+    unsigned short behaviour_bit_field;
+};
 
 #endif // __DESCRIBE_PRC_H
@@ -0,0 +1,455 @@
+/************
+*
+*   This file is part of a tool for reading 3D content in the PRC format.
+*   Copyright (C) 2008 Orest Shardt <shardtor (at) gmail dot com>
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU Lesser General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU Lesser General Public License for more details.
+*
+*   You should have received a copy of the GNU Lesser General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*************/
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <cstring>
+#include <charconv>
+#include <cstdlib>
+#include "iPRCFile.h"
+#include "describeEmitter.h"
+#include "threadPool.h"
+
+using namespace std;
+
+// how far ahead to look for matching events after a structural difference
+const unsigned int RESYNC_WINDOW = 256;
+
+// one thing found while describing a part
+struct DiffEvent
+{
+  enum Kind { ENTITY, VALUES, TEXT } kind;
+  string name; // entity type or field label
+  unsigned int depth;
+  int parent; // index of the enclosing entity, -1 at the top of the part
+  unsigned int ordinal; // of an entity among its siblings of the same type
+  vector<double> values;
+  string text;
+};
+
+// Records the events of one part so that two descriptions can be
+// compared. Labels lose their trailing separators.
+class DiffRecorder : public DescribeEmitter
+{
+  public:
+    DiffRecorder(OutputSink &o) : DescribeEmitter(o),siblings(1) {}
+
+    DescribeEmitter* createPart(OutputSink &o, const string&) const
+    {
+      return new DiffRecorder(o);
+    }
+
+    void beginFile(const string&) {}
+    void endFile(const string&, const char*) {}
+    void fileStructure(unsigned int) {}
+    void entity(const char *type)
+    {
+      DiffEvent &event = add(DiffEvent::ENTITY,type);
+      event.ordinal = siblings.back()[event.name]++;
+      open.push_back(events.size()-1);
+      siblings.push_back(map<string,unsigned int>());
+    }
+    void endEntity()
+    {
+      if(open.empty())
+        return;
+      open.pop_back();
+      siblings.pop_back();
+    }
+    void sectionCode(unsigned int found, unsigned int expected)
+    {
+      double values[2] = { double(found), double(expected) };
+      addValues("section code",values,2);
+    }
+
+    void field(const char *label, int value, const char*)
+    {
+      double v = value;
+      addValues(label,&v,1);
+    }
+    void field(const char *label, unsigned int value, const char*)
+    {
+      double v = value;
+      addValues(label,&v,1);
+    }
+    void field(const char *label, double value, const char*)
+    {
+      addValues(label,&value,1);
+    }
+    void flag(const char *label, bool value)
+    {
+      double v = value;
+      addValues(label,&v,1);
+    }
+    void text(const char *label, const string &value, bool)
+    {
+      add(DiffEvent::TEXT,label).text = value;
+    }
+    void coordinates(const char *label, const double *values,
+                     unsigned int count)
+    {
+      addValues(label,values,count);
+    }
+    void colour(double r, double g, double b)
+    {
+      double values[3] = { r, g, b };
+      addValues("colour",values,3);
+    }
+    void row(const unsigned int *values, unsigned int count)
+    {
+      DiffEvent &event = add(DiffEvent::VALUES,"row");
+      event.values.assign(values,values+count);
+    }
+    void uuid(const char *label, const unsigned int id[4])
+    {
+      DiffEvent &event = add(DiffEvent::VALUES,label);
+      event.values.assign(id,id+4);
+    }
+    void userData(const string &bits)
+    {
+      add(DiffEvent::TEXT,"user data").text = bits;
+    }
+
+    void array(const char *name, const vector<double> &values)
+    {
+      add(DiffEvent::VALUES,name).values = values;
+    }
+    void array(const char *name, const vector<unsigned int> &values)
+    {
+      DiffEvent &event = add(DiffEvent::VALUES,name);
+      event.values.assign(values.begin(),values.end());
+    }
+
+    void note(const char *message)
+    {
+      add(DiffEvent::TEXT,"note").text = message;
+    }
+    void warning(const char *message)
+    {
+      add(DiffEvent::TEXT,"warning").text = message;
+    }
+    void position() {}
+    void blankLine() {}
+
+    void beginBitDump() { add(DiffEvent::TEXT,"undecoded bits"); }
+    void dumpBit(bool b) { events.back().text += b ? '1' : '0'; }
+    void endBitDump() {}
+
+    vector<DiffEvent> events;
+
+  private:
+    DiffEvent& add(DiffEvent::Kind kind, const char *label)
+    {
+      events.push_back(DiffEvent());
+      DiffEvent &event = events.back();
+      event.kind = kind;
+      event.name = label;
+      while(!event.name.empty() &&
+            strchr(" :=",event.name[event.name.size()-1]) != NULL)
+        event.name.erase(event.name.size()-1);
+      event.depth = open.size();
+      event.parent = open.empty() ? -1 : open.back();
+      event.ordinal = 0;
+      return event;
+    }
+    void addValues(const char *label, const double *values,
+                   unsigned int count)
+    {
+      add(DiffEvent::VALUES,label).values.assign(values,values+count);
+    }
+
+    vector<int> open; // entities that have not ended
+    vector<map<string,unsigned int> > siblings; // counts, per open entity
+};
+
+struct Tolerance
+{
+  double absolute;
+  double relative;
+
+  bool equal(double a, double b) const
+  {
+    if(a == b)
+      return true;
+    return fabs(a-b) <= absolute+relative*max(fabs(a),fabs(b));
+  }
+};
+
+static string formatNumber(double value)
+{
+  char digits[32];
+  return string(digits,to_chars(digits,digits+32,value).ptr);
+}
+
+// Compares the events of a part in two files and writes a line per
+// difference.
+class PartComparison
+{
+  public:
+    PartComparison(const string &part, const vector<DiffEvent> &first,
+                   const vector<DiffEvent> &second,
+                   const Tolerance &tolerance, unsigned int maxReported,
+                   ostream &out) : part(part),a(first),b(second),
+        tolerance(tolerance),maxReported(maxReported),out(out),
+        differences(0) {}
+
+    unsigned int compare();
+
+  private:
+    bool match(unsigned int i, unsigned int j) const
+    {
+      return a[i].kind == b[j].kind && a[i].depth == b[j].depth &&
+          a[i].name == b[j].name;
+    }
+    string path(const vector<DiffEvent>&, int) const;
+    void compareValues(unsigned int i, unsigned int j);
+    void onlyIn(const vector<DiffEvent>&, unsigned int first,
+                unsigned int end, const char *file);
+    ostream& report();
+
+    const string &part;
+    const vector<DiffEvent> &a, &b;
+    const Tolerance &tolerance;
+    const unsigned int maxReported;
+    ostream &out;
+    unsigned int differences;
+    ostringstream ignored;
+};
+
+// Walk both lists in step. Where the structure differs, skip ahead to the
+// closest pair of matching events and report what was skipped.
+unsigned int PartComparison::compare()
+{
+  unsigned int i = 0, j = 0;
+  while(i < a.size() && j < b.size())
+  {
+    if(match(i,j))
+    {
+      compareValues(i++,j++);
+      continue;
+    }
+    bool found = false;
+    for(unsigned int distance = 1; !found && distance <= RESYNC_WINDOW;
+        ++distance)
+      for(unsigned int k = 0; !found && k <= distance; ++k)
+        if(i+k < a.size() && j+distance-k < b.size() &&
+           match(i+k,j+distance-k))
+        {
+          onlyIn(a,i,i+k,"first");
+          onlyIn(b,j,j+distance-k,"second");
+          i += k;
+          j += distance-k;
+          found = true;
+        }
+    if(!found)
+    {
+      report() << path(a,i) << ": structure differs from " << path(b,j)
+               << ", rest of part not compared" << endl;
+      return differences;
+    }
+  }
+  onlyIn(a,i,a.size(),"first");
+  onlyIn(b,j,b.size(),"second");
+  return differences;
+}
+
+string PartComparison::path(const vector<DiffEvent> &events, int i) const
+{
+  string result;
+  for(; i >= 0; i = events[i].parent)
+  {
+    string name = events[i].name;
+    if(events[i].kind == DiffEvent::ENTITY)
+      name += '[' + to_string(events[i].ordinal) + ']';
+    result = '/' + name + result;
+  }
+  return part + result;
+}
+
+void PartComparison::compareValues(unsigned int i, unsigned int j)
+{
+  const DiffEvent &x = a[i], &y = b[j];
+  if(x.kind == DiffEvent::TEXT && x.text != y.text)
+    report() << path(a,i) << ": \"" << x.text << "\" -> \"" << y.text
+             << '"' << endl;
+  if(x.kind != DiffEvent::VALUES)
+    return;
+  if(x.values.size() != y.values.size())
+  {
+    report() << path(a,i) << ": " << x.values.size() << " values -> "
+             << y.values.size() << " values" << endl;
+    return;
+  }
+  unsigned int count = 0, firstIndex = 0;
+  for(unsigned int k = 0; k < x.values.size(); ++k)
+    if(!tolerance.equal(x.values[k],y.values[k]) && count++ == 0)
+      firstIndex = k;
+  if(count == 0)
+    return;
+  ostream &o = report() << path(a,i) << ": ";
+  if(x.values.size() > 1)
+    o << count << " of " << x.values.size() << " values differ, first at "
+      << firstIndex << ": ";
+  o << formatNumber(x.values[firstIndex]) << " -> "
+    << formatNumber(y.values[firstIndex]) << endl;
+}
+
+// report the events in [first,end) that are not inside a reported entity
+void PartComparison::onlyIn(const vector<DiffEvent> &events,
+                            unsigned int first, unsigned int end,
+                            const char *file)
+{
+  for(unsigned int i = first; i < end; ++i)
+    if(events[i].parent < int(first))
+      report() << path(events,i) << ": only in " << file << " file"
+               << endl;
+}
+
+// where the next difference goes, nowhere once enough were reported
+ostream& PartComparison::report()
+{
+  ++differences;
+  if(differences > maxReported)
+  {
+    ignored.str("");
+    return ignored;
+  }
+  return out;
+}
+
+static bool describePart(iPRCFile &file, unsigned int part,
+                         vector<DiffEvent> &events)
+{
+  ostringstream ignored;
+  OutputSink sink(ignored);
+  DiffRecorder recorder(sink);
+  bool complete = file.describePart(recorder,part);
+  events.swap(recorder.events);
+  return complete;
+}
+
+int main(int argc, char* argv[])
+{
+  // diffPRC [-tolerance absolute] [-relative relative] [-max count]
+  //         first.prc second.prc
+  Tolerance tolerance = { 0, 0 };
+  unsigned int maxReported = 100;
+  int arg = 1;
+  for(; arg < argc-2 && argv[arg][0] == '-'; ++arg)
+  {
+    if(string(argv[arg]) == "-tolerance" && arg+1 < argc-2)
+      tolerance.absolute = atof(argv[++arg]);
+    else if(string(argv[arg]) == "-relative" && arg+1 < argc-2)
+      tolerance.relative = atof(argv[++arg]);
+    else if(string(argv[arg]) == "-max" && arg+1 < argc-2)
+      maxReported = atoi(argv[++arg]);
+    else
+    {
+      cerr << "Error: Unknown option " << argv[arg] << endl;
+      return 2;
+    }
+  }
+  if(arg+2 != argc)
+  {
+    cerr << "Usage: diffPRC [-tolerance absolute] [-relative relative] "
+            "[-max count] first.prc second.prc" << endl;
+    return 2;
+  }
+
+  iPRCFile first(argv[arg]), second(argv[arg+1]);
+  if(!first.isValid() || !second.isValid())
+  {
+    cerr << "Error: Cannot read input file." << endl;
+    return 2;
+  }
+
+  // parts are paired by name; file structures only one file has are
+  // reported as a whole
+  vector<pair<unsigned int,unsigned int> > pairs;
+  const unsigned int common = min(first.getNumberOfFileStructures(),
+                                  second.getNumberOfFileStructures());
+  for(unsigned int part = 0; part < 6*common; ++part)
+    pairs.push_back(make_pair(part,part));
+  pairs.push_back(make_pair(first.getNumberOfParts()-1,
+                            second.getNumberOfParts()-1));
+
+  // Parts whose inflated data is identical are done; the others are
+  // described and compared event by event.
+  vector<string> output(pairs.size());
+  vector<unsigned int> differences(pairs.size());
+  ThreadPool::global().parallelFor(pairs.size(),[&](unsigned int p)
+  {
+    const unsigned int i = pairs[p].first, j = pairs[p].second;
+    if(i%6 != 0 || i == first.getNumberOfParts()-1)
+    {
+      SectionData x = first.getPartData(i), y = second.getPartData(j);
+      if(x.length == y.length &&
+         (x.length == 0 || memcmp(x.data.get(),y.data.get(),x.length) == 0))
+        return;
+    }
+    vector<DiffEvent> a, b;
+    ostringstream text;
+    const string name = first.partName(i);
+    const bool completeA = describePart(first,i,a);
+    const bool completeB = describePart(second,j,b);
+    if(completeA != completeB)
+      text << name << ": ends early in " << (completeA ? "second" : "first")
+           << " file" << endl;
+    PartComparison comparison(name,a,b,tolerance,maxReported,text);
+    differences[p] = comparison.compare() + (completeA != completeB);
+    if(differences[p] == 0 && i%6 != 0 && tolerance.absolute == 0 &&
+       tolerance.relative == 0)
+    {
+      // e.g. bits that are not decoded
+      text << name << ": data differs, descriptions are the same" << endl;
+      differences[p] = 1;
+    }
+    if(differences[p] > maxReported)
+      text << name << ": " << differences[p]-maxReported
+           << " more differences" << endl;
+    output[p] = text.str();
+  });
+
+  unsigned int total = 0, differingParts = 0;
+  for(unsigned int p = 0; p < pairs.size(); ++p)
+  {
+    cout << output[p];
+    total += differences[p];
+    if(differences[p] > 0)
+      ++differingParts;
+  }
+  for(unsigned int i = common; i < first.getNumberOfFileStructures(); ++i)
+  {
+    cout << "Structure" << i << ": only in first file" << endl;
+    ++total;
+  }
+  for(unsigned int i = common; i < second.getNumberOfFileStructures(); ++i)
+  {
+    cout << "Structure" << i << ": only in second file" << endl;
+    ++total;
+  }
+  cout << total << " differences, " << differingParts << " of "
+       << pairs.size() << " compared parts differ." << endl;
+  return total == 0 ? 0 : 1;
+}
@@ -0,0 +1,263 @@
+/************
+*
+*   This file is part of a tool for reading 3D content in the PRC format.
+*   Copyright (C) 2008 Orest Shardt <shardtor (at) gmail dot com>
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU Lesser General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU Lesser General Public License for more details.
+*
+*   You should have received a copy of the GNU Lesser General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*************/
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include "entityIndex.h"
+#include "iPRCFile.h"
+#include "describeEmitter.h"
+#include "threadPool.h"
+
+using std::string; using std::vector; using std::map;
+
+// "PRCIDX" and a format version
+static const char indexSignature[8] = { 'P','R','C','I','D','X','0','2' };
+
+// Records where the entities one level inside the part's outermost
+// entities start. Everything else is ignored, and long lists of values
+// are skipped.
+class IndexEmitter : public DescribeEmitter
+{
+  public:
+    IndexEmitter(OutputSink &o) : DescribeEmitter(o),nesting(0) {}
+
+    DescribeEmitter* createPart(OutputSink &o, const string&) const
+    {
+      return new IndexEmitter(o);
+    }
+    bool wantsValues() const { return false; }
+
+    void entity(const char *type)
+    {
+      if(nesting++ == 1 && source != NULL)
+      {
+        IndexEntry entry;
+        entry.position = source->getPosition();
+        map<string,unsigned int>::iterator it = typeIndexes.find(type);
+        if(it == typeIndexes.end())
+        {
+          it = typeIndexes.insert(std::make_pair(string(type),
+                                                 typeNames.size())).first;
+          typeNames.push_back(type);
+        }
+        entry.type = it->second;
+        entries.push_back(entry);
+      }
+    }
+    void endEntity() { if(nesting > 0) --nesting; }
+
+    void beginFile(const string&) {}
+    void endFile(const string&,const char*) {}
+    void fileStructure(unsigned int) {}
+    void sectionCode(unsigned int,unsigned int) {}
+    void field(const char*,int,const char* = NULL) {}
+    void field(const char*,unsigned int,const char* = NULL) {}
+    void field(const char*,double,const char* = NULL) {}
+    void flag(const char*,bool) {}
+    void text(const char*,const string&,bool = true) {}
+    void coordinates(const char*,const double*,unsigned int) {}
+    void colour(double,double,double) {}
+    void row(const unsigned int*,unsigned int) {}
+    void uuid(const char*,const unsigned int[4]) {}
+    void userData(const string&) {}
+    void array(const char*,const vector<double>&) {}
+    void array(const char*,const vector<unsigned int>&) {}
+    void note(const char*) {}
+    void warning(const char*) {}
+    void position() {}
+    void blankLine() {}
+    void beginBitDump() {}
+    void dumpBit(bool) {}
+    void endBitDump() {}
+
+    vector<IndexEntry> entries; // types index typeNames
+    vector<string> typeNames;
+
+  private:
+    unsigned int nesting; // entities that have not ended
+    map<string,unsigned int> typeIndexes;
+};
+
+void EntityIndex::build(iPRCFile &file)
+{
+  prcFileSize = file.getFileSize();
+  prcFileHash = file.getContentHash();
+  const unsigned int numberOfParts = file.getNumberOfParts();
+  vector<vector<IndexEntry> > found(numberOfParts);
+  vector<vector<string> > foundTypes(numberOfParts);
+  ThreadPool::global().parallelFor(numberOfParts,[&](unsigned int p)
+  {
+    std::ostringstream ignored;
+    OutputSink sink(ignored);
+    IndexEmitter emitter(sink);
+    file.describePart(emitter,p);
+    found[p].swap(emitter.entries);
+    foundTypes[p].swap(emitter.typeNames);
+  });
+
+  // one table of type names for all parts
+  typeNames.clear();
+  map<string,unsigned int> typeIndexes;
+  parts.assign(numberOfParts,vector<IndexEntry>());
+  for(unsigned int p = 0; p < numberOfParts; ++p)
+  {
+    vector<unsigned int> types;
+    for(unsigned int t = 0; t < foundTypes[p].size(); ++t)
+    {
+      map<string,unsigned int>::iterator it =
+          typeIndexes.find(foundTypes[p][t]);
+      if(it == typeIndexes.end())
+      {
+        it = typeIndexes.insert(std::make_pair(foundTypes[p][t],
+                                               typeNames.size())).first;
+        typeNames.push_back(foundTypes[p][t]);
+      }
+      types.push_back(it->second);
+    }
+    for(unsigned int e = 0; e < found[p].size(); ++e)
+      found[p][e].type = types[found[p][e].type];
+    parts[p].swap(found[p]);
+  }
+}
+
+const IndexEntry* EntityIndex::find(unsigned int part, const string &type,
+                                    unsigned int n) const
+{
+  if(part >= parts.size())
+    return NULL;
+  for(unsigned int e = 0; e < parts[part].size(); ++e)
+    if(typeNames[parts[part][e].type] == type && n-- == 0)
+      return &parts[part][e];
+  return NULL;
+}
+
+// The sidecar stores numbers as variable length integers, 7 bits per
+// byte with the high bit set on all but the last byte. Entity positions
+// are stored as the number of bits since the previous entity.
+static void writeNumber(std::ostream &out, uint64_t value)
+{
+  while(value >= 0x80)
+  {
+    out.put(static_cast<char>(0x80 | (value & 0x7F)));
+    value >>= 7;
+  }
+  out.put(static_cast<char>(value));
+}
+
+static bool readNumber(std::istream &in, uint64_t &value)
+{
+  value = 0;
+  for(unsigned int shift = 0; shift < 64; shift += 7)
+  {
+    int c = in.get();
+    if(c == EOF)
+      return false;
+    value |= static_cast<uint64_t>(c & 0x7F) << shift;
+    if((c & 0x80) == 0)
+      return true;
+  }
+  return false;
+}
+
+bool EntityIndex::write(const string &fileName) const
+{
+  std::ofstream out(fileName.c_str(),std::ios::out | std::ios::binary);
+  if(!out)
+    return false;
+  out.write(indexSignature,sizeof(indexSignature));
+  writeNumber(out,prcFileSize);
+  writeNumber(out,prcFileHash);
+  writeNumber(out,typeNames.size());
+  for(unsigned int t = 0; t < typeNames.size(); ++t)
+  {
+    writeNumber(out,typeNames[t].size());
+    out.write(typeNames[t].data(),typeNames[t].size());
+  }
+  writeNumber(out,parts.size());
+  for(unsigned int p = 0; p < parts.size(); ++p)
+  {
+    writeNumber(out,parts[p].size());
+    uint64_t previous = 0;
+    for(unsigned int e = 0; e < parts[p].size(); ++e)
+    {
+      const BitPosition &position = parts[p][e].position;
+      uint64_t bit = 8*position.byteIndex + position.bitIndex;
+      writeNumber(out,bit-previous);
+      writeNumber(out,parts[p][e].type);
+      previous = bit;
+    }
+  }
+  return out.good();
+}
+
+bool EntityIndex::read(const string &fileName, const iPRCFile &file)
+{
+  std::ifstream in(fileName.c_str(),std::ios::in | std::ios::binary);
+  char signature[sizeof(indexSignature)];
+  if(!in || !in.read(signature,sizeof(signature)) ||
+     !std::equal(signature,signature+sizeof(signature),indexSignature))
+    return false;
+  uint64_t size, hash, numberOfTypes, numberOfParts;
+  if(!readNumber(in,size) || size != file.getFileSize() ||
+     !readNumber(in,hash) || hash != file.getContentHash() ||
+     !readNumber(in,numberOfTypes))
+    return false;
+  vector<string> types;
+  for(uint64_t t = 0; t < numberOfTypes; ++t)
+  {
+    uint64_t length;
+    if(!readNumber(in,length) || length > 1024)
+      return false;
+    string name(length,'\0');
+    if(!in.read(&name[0],length))
+      return false;
+    types.push_back(name);
+  }
+  if(!readNumber(in,numberOfParts))
+    return false;
+  vector<vector<IndexEntry> > entries;
+  for(uint64_t p = 0; p < numberOfParts; ++p)
+  {
+    uint64_t count, bit = 0;
+    if(!readNumber(in,count))
+      return false;
+    entries.push_back(vector<IndexEntry>());
+    for(uint64_t e = 0; e < count; ++e)
+    {
+      uint64_t delta, type;
+      if(!readNumber(in,delta) || !readNumber(in,type) ||
+         type >= types.size())
+        return false;
+      bit += delta;
+      IndexEntry entry;
+      entry.position.byteIndex = bit/8;
+      entry.position.bitIndex = bit%8;
+      entry.type = type;
+      entries.back().push_back(entry);
+    }
+  }
+  prcFileSize = size;
+  prcFileHash = hash;
+  typeNames.swap(types);
+  parts.swap(entries);
+  return true;
+}
@@ -0,0 +1,77 @@
+/************
+*
+*   This file is part of a tool for reading 3D content in the PRC format.
+*   Copyright (C) 2008 Orest Shardt <shardtor (at) gmail dot com>
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU Lesser General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU Lesser General Public License for more details.
+*
+*   You should have received a copy of the GNU Lesser General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*************/
+
+#ifndef __ENTITY_INDEX_H
+#define __ENTITY_INDEX_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "bitData.h"
+
+class iPRCFile;
+
+struct IndexEntry
+{
+  BitPosition position; // where the entity starts in its part
+  unsigned int type; // see EntityIndex::getTypeName()
+};
+
+// Where the top-level entities of each part of a PRC file start, i.e. the
+// entities directly inside a section such as the product occurrences of
+// a tree. The sections carry no entity lengths, so the index is built by
+// describing every part once; after that an entity can be described on
+// its own with BitByBitData::setPosition() and
+// PRCDescriber::describeEntity(). The index can be kept in a sidecar
+// file next to the PRC file.
+class EntityIndex
+{
+  public:
+    EntityIndex() : prcFileSize(0),prcFileHash(0) {}
+
+    // index all parts of a file in parallel
+    void build(iPRCFile&);
+    bool write(const std::string &fileName) const;
+    // false if the file is missing or damaged or was written for a PRC
+    // file of another size or content
+    bool read(const std::string &fileName, const iPRCFile&);
+
+    // parts are numbered as by iPRCFile::partName()
+    unsigned int getNumberOfParts() const { return parts.size(); }
+    const std::vector<IndexEntry>& getEntries(unsigned int part) const
+    {
+      return parts[part];
+    }
+    const std::string& getTypeName(unsigned int type) const
+    {
+      return typeNames[type];
+    }
+    // the n-th entity of a type in a part, NULL if there is none
+    const IndexEntry* find(unsigned int part, const std::string &type,
+                           unsigned int n) const;
+
+  private:
+    uint64_t prcFileSize;
+    uint64_t prcFileHash; // see iPRCFile::getContentHash()
+    std::vector<std::string> typeNames;
+    std::vector<std::vector<IndexEntry> > parts;
+};
+
+#endif // __ENTITY_INDEX_H
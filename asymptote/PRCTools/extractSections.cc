@@ -21,6 +21,7 @@
 #include <iostream>
 #include <fstream>
 #include "iPRCFile.h"
+#include "pdfFile.h"
 
 using namespace std;
 
@@ -31,16 +32,30 @@ int main(int argc, char* argv[])
     cerr << "Error: Input file not specified." << endl;
     return 1;
   }
-  ifstream inFile(argv[1]);
-  if(!inFile)
+  PRCInput input(argv[1]);
+  if(!input.isValid() || input.getNumberOfFiles() == 0)
   {
-    cerr << "Error: Cannot open input file." << endl;
+    cerr << "Error: Cannot read input file." << endl;
     return 1;
   }
-
-  iPRCFile myFile(inFile);
   string name(argv[1]);
-  myFile.dumpSections(name.substr(0,name.find(".")).c_str());
+  name = name.substr(0,name.find("."));
+  int result = 0;
+  for(unsigned int i = 0; i < input.getNumberOfFiles(); ++i)
+  {
+    iPRCFile *myFile = input.open(i);
+    if(!myFile->isValid())
+    {
+      cerr << "Error: Cannot read " << input.getName(i) << "." << endl;
+      result = 1;
+    }
+    // the streams of a PDF file are numbered
+    else if(input.getNumberOfFiles() > 1)
+      myFile->dumpSections((name+"-"+to_string(i)).c_str());
+    else
+      myFile->dumpSections(name.c_str());
+    delete myFile;
+  }
 
-  return 0;
+  return result;
 }
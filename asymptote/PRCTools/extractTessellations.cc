@@ -0,0 +1,345 @@
+/************
+*
+*   This file is part of a tool for reading 3D content in the PRC format.
+*   Copyright (C) 2008 Orest Shardt <shardtor (at) gmail dot com>
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU Lesser General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU Lesser General Public License for more details.
+*
+*   You should have received a copy of the GNU Lesser General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*************/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+#include "iPRCFile.h"
+#include "pdfFile.h"
+#include "describePRC.h"
+#include "tessellationEmitter.h"
+#include "threadPool.h"
+
+using namespace std;
+
+// 3D tessellations of a PRC file as triangles
+struct TriangleMesh
+{
+  vector<double> coordinates; // x y z of each point
+  vector<uint32_t> triangles; // three point indices each
+};
+
+// all binary formats are written little endian
+static void writeUInt32(ostream &out, uint32_t value)
+{
+  unsigned char bytes[4] = { (unsigned char)value, (unsigned char)(value>>8),
+      (unsigned char)(value>>16), (unsigned char)(value>>24) };
+  out.write(reinterpret_cast<char*>(bytes),4);
+}
+
+static void writeFloat(ostream &out, double value)
+{
+  float f = static_cast<float>(value);
+  uint32_t bits;
+  memcpy(&bits,&f,4);
+  writeUInt32(out,bits);
+}
+
+// The MSH format of FreeCAD's mesh module, as read by loadMesh() in
+// mshtoprc: points, facets with the indices of their neighbours and the
+// bounding box.
+static void writeMSH(ostream &out, const TriangleMesh &mesh)
+{
+  const uint32_t openEdge = 0xffffffff;
+  const uint32_t numberOfPoints = mesh.coordinates.size()/3;
+  const uint32_t numberOfFacets = mesh.triangles.size()/3;
+
+  // facets that share an edge are neighbours; edges used by more than two
+  // facets are treated as open
+  vector<pair<uint64_t,uint32_t> > edges; // (edge, facet*3+side)
+  edges.reserve(mesh.triangles.size());
+  for(uint32_t i = 0; i < mesh.triangles.size(); ++i)
+  {
+    uint64_t a = mesh.triangles[i];
+    uint64_t b = mesh.triangles[i%3 == 2 ? i-2 : i+1];
+    edges.push_back(make_pair(min(a,b)<<32 | max(a,b),i));
+  }
+  sort(edges.begin(),edges.end());
+  vector<uint32_t> neighbours(mesh.triangles.size(),openEdge);
+  for(size_t i = 0; i < edges.size(); )
+  {
+    size_t j = i+1;
+    while(j < edges.size() && edges[j].first == edges[i].first)
+      ++j;
+    if(j-i == 2)
+    {
+      neighbours[edges[i].second] = edges[i+1].second/3;
+      neighbours[edges[i+1].second] = edges[i].second/3;
+    }
+    i = j;
+  }
+
+  writeUInt32(out,0xA0B0C0D0);
+  writeUInt32(out,0x010000);
+  char info[256];
+  memset(info,0,sizeof(info));
+  strncpy(info,"Extracted from PRC",sizeof(info)-1);
+  out.write(info,sizeof(info));
+  writeUInt32(out,numberOfPoints);
+  writeUInt32(out,numberOfFacets);
+
+  double low[3] = { DBL_MAX, DBL_MAX, DBL_MAX };
+  double high[3] = { -DBL_MAX, -DBL_MAX, -DBL_MAX };
+  for(uint32_t i = 0; i < 3*numberOfPoints; ++i)
+  {
+    writeFloat(out,mesh.coordinates[i]);
+    low[i%3] = min(low[i%3],mesh.coordinates[i]);
+    high[i%3] = max(high[i%3],mesh.coordinates[i]);
+  }
+  for(uint32_t i = 0; i < numberOfFacets; ++i)
+  {
+    for(unsigned int j = 0; j < 3; ++j)
+      writeUInt32(out,mesh.triangles[3*i+j]);
+    for(unsigned int j = 0; j < 3; ++j)
+      writeUInt32(out,neighbours[3*i+j]);
+  }
+  for(unsigned int j = 0; j < 3; ++j)
+  {
+    writeFloat(out,numberOfPoints ? low[j] : 0);
+    writeFloat(out,numberOfPoints ? high[j] : 0);
+  }
+}
+
+static void writeSTL(ostream &out, const TriangleMesh &mesh)
+{
+  char header[80];
+  memset(header,0,sizeof(header));
+  strncpy(header,"Extracted from PRC",sizeof(header)-1);
+  out.write(header,sizeof(header));
+  writeUInt32(out,mesh.triangles.size()/3);
+  for(size_t i = 0; i < mesh.triangles.size(); i += 3)
+  {
+    const double *p[3];
+    for(unsigned int j = 0; j < 3; ++j)
+      p[j] = &mesh.coordinates[3*mesh.triangles[i+j]];
+    double u[3], v[3], n[3];
+    for(unsigned int j = 0; j < 3; ++j)
+    {
+      u[j] = p[1][j]-p[0][j];
+      v[j] = p[2][j]-p[0][j];
+    }
+    n[0] = u[1]*v[2]-u[2]*v[1];
+    n[1] = u[2]*v[0]-u[0]*v[2];
+    n[2] = u[0]*v[1]-u[1]*v[0];
+    double length = sqrt(n[0]*n[0]+n[1]*n[1]+n[2]*n[2]);
+    for(unsigned int j = 0; j < 3; ++j)
+      writeFloat(out,length > 0 ? n[j]/length : 0);
+    for(unsigned int j = 0; j < 3; ++j)
+      for(unsigned int k = 0; k < 3; ++k)
+        writeFloat(out,p[j][k]);
+    out.write("\0\0",2); // attribute byte count
+  }
+}
+
+static void writePLY(ostream &out, const TriangleMesh &mesh)
+{
+  out << "ply\n"
+      << "format binary_little_endian 1.0\n"
+      << "comment Extracted from PRC\n"
+      << "element vertex " << mesh.coordinates.size()/3 << '\n'
+      << "property float x\n"
+      << "property float y\n"
+      << "property float z\n"
+      << "element face " << mesh.triangles.size()/3 << '\n'
+      << "property list uchar uint vertex_indices\n"
+      << "end_header\n";
+  for(size_t i = 0; i < mesh.coordinates.size(); ++i)
+    writeFloat(out,mesh.coordinates[i]);
+  for(size_t i = 0; i < mesh.triangles.size(); i += 3)
+  {
+    out.put(3);
+    for(unsigned int j = 0; j < 3; ++j)
+      writeUInt32(out,mesh.triangles[i+j]);
+  }
+}
+
+static bool writeMesh(const string &fileName, const string &format,
+                      const TriangleMesh &mesh)
+{
+  ofstream out(fileName.c_str(),ios::out | ios::binary);
+  if(!out)
+  {
+    cerr << "Error: Cannot create " << fileName << "." << endl;
+    return false;
+  }
+  if(format == "stl")
+    writeSTL(out,mesh);
+  else if(format == "ply")
+    writePLY(out,mesh);
+  else
+    writeMSH(out,mesh);
+  return out.good();
+}
+
+// Append the 3D tessellations of a PRC file. The tessellations of a
+// section can only be found by reading through it, so the sections are
+// decoded in parallel. The tree sections are read too; returns true if
+// they place anything by a transformation.
+static bool readTessellations(iPRCFile &inputFile,
+                              vector<Tessellation3D> &tessellations)
+{
+  const unsigned int numberOfFileStructures =
+      inputFile.getNumberOfFileStructures();
+  vector<vector<Tessellation3D> > sections(numberOfFileStructures);
+  vector<char> complete(numberOfFileStructures);
+  vector<char> transformed(numberOfFileStructures);
+  ThreadPool::global().parallelFor(numberOfFileStructures,[&](unsigned int i)
+  {
+    SectionData section = inputFile.getSection(i,TESSELLATION_SECTION);
+    BitByBitData data(section.data.get(),section.length);
+    SectionData treeSection = inputFile.getSection(i,TREE_SECTION);
+    BitByBitData tree(treeSection.data.get(),treeSection.length);
+    ostringstream ignored;
+    {
+      OutputSink sink(ignored);
+      TessellationEmitter emitter(sink);
+      PRCDescriber describer(emitter);
+      emitter.setSource(&data);
+      describer.describeTessellation(data);
+      emitter.setSource(&tree);
+      describer.describeTree(tree);
+      emitter.setSource(NULL);
+      sections[i].swap(emitter.tessellations);
+      transformed[i] = emitter.transformed;
+    }
+    complete[i] = !data.readFailed();
+  });
+
+  for(unsigned int i = 0; i < numberOfFileStructures; ++i)
+  {
+    if(!complete[i])
+      cerr << "Warning: Tessellation section of file structure " << i
+           << " ended early, its last tessellation may be incomplete."
+           << endl;
+    for(unsigned int j = 0; j < sections[i].size(); ++j)
+      tessellations.push_back(std::move(sections[i][j]));
+  }
+  return find(transformed.begin(),transformed.end(),1) != transformed.end();
+}
+
+int main(int argc, char* argv[])
+{
+  // extractTessellations [-format msh|stl|ply] [-split] file.prc|pdf output
+  string format = "msh";
+  bool split = false;
+  int arg = 1;
+  for(; arg < argc-2 && argv[arg][0] == '-'; ++arg)
+  {
+    if(string(argv[arg]) == "-format" && arg+1 < argc-2)
+      format = argv[++arg];
+    else if(string(argv[arg]) == "-split")
+      split = true;
+    else
+    {
+      cerr << "Error: Unknown option " << argv[arg] << endl;
+      return 1;
+    }
+  }
+  if(arg+2 != argc)
+  {
+    cerr << "Usage: extractTessellations [-format msh|stl|ply] [-split] "
+            "file.prc|pdf output" << endl;
+    return 1;
+  }
+  if(format != "msh" && format != "stl" && format != "ply")
+  {
+    cerr << "Error: Unknown format " << format << endl;
+    return 1;
+  }
+
+  // all PRC streams of a PDF file are read
+  PRCInput input(argv[arg]);
+  if(!input.isValid() || input.getNumberOfFiles() == 0)
+  {
+    cerr << "Error: Cannot read input file." << endl;
+    return 1;
+  }
+  vector<Tessellation3D> tessellations;
+  bool transformed = false;
+  for(unsigned int i = 0; i < input.getNumberOfFiles(); ++i)
+  {
+    iPRCFile *inputFile = input.open(i);
+    bool valid = inputFile->isValid();
+    if(valid && readTessellations(*inputFile,tessellations))
+      transformed = true;
+    delete inputFile;
+    if(!valid)
+    {
+      cerr << "Error: Cannot read " << input.getName(i) << "." << endl;
+      return 1;
+    }
+  }
+
+  // then the tessellations are triangulated in parallel
+  ThreadPool &pool = ThreadPool::global();
+  vector<TriangleMesh> meshes(tessellations.size());
+  vector<char> understood(tessellations.size());
+  pool.parallelFor(tessellations.size(),[&](unsigned int i)
+  {
+    meshes[i].coordinates = tessellations[i].coordinates;
+    understood[i] = tessellations[i].triangulate(meshes[i].triangles);
+  });
+  for(unsigned int i = 0; i < meshes.size(); ++i)
+    if(!understood[i])
+      cerr << "Warning: Some faces of tessellation " << i
+           << " could not be read." << endl;
+  // The product tree is not followed: each tessellation is written once,
+  // in its own coordinates, however often and wherever it is used.
+  if(transformed)
+    cerr << "Warning: The file places tessellations by transformations, "
+            "e.g. instances of one mesh. These are not applied; each "
+            "tessellation is written once in its own coordinates." << endl;
+
+  const string output = argv[arg+1];
+  if(split)
+  {
+    // output is a prefix: output-0.msh, output-1.msh, ...
+    for(unsigned int i = 0; i < meshes.size(); ++i)
+    {
+      ostringstream name;
+      name << output << '-' << i << '.' << format;
+      if(!writeMesh(name.str(),format,meshes[i]))
+        return 1;
+    }
+  }
+  else
+  {
+    TriangleMesh all;
+    for(unsigned int i = 0; i < meshes.size(); ++i)
+    {
+      const uint32_t offset = all.coordinates.size()/3;
+      all.coordinates.insert(all.coordinates.end(),
+          meshes[i].coordinates.begin(),meshes[i].coordinates.end());
+      for(unsigned int j = 0; j < meshes[i].triangles.size(); ++j)
+        all.triangles.push_back(meshes[i].triangles[j]+offset);
+      vector<double>().swap(meshes[i].coordinates);
+    }
+    if(!writeMesh(output,format,all))
+      return 1;
+  }
+  cerr << meshes.size() << " tessellations extracted." << endl;
+  return 0;
+}
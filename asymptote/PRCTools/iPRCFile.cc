@@ -18,9 +18,14 @@
 *
 *************/
 
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
 #include "bitData.h"
 #include "iPRCFile.h"
 #include "describePRC.h"
+#include "threadPool.h"
+#include "sectionCache.h"
 
 using std::vector; using std::istream; using std::ios;
 using std::cout; using std::endl; using std::cerr;
@@ -29,41 +34,180 @@ using std::string;
 using std::ofstream;
 using std::ostringstream;
 
+static const char *sectionNames[5] =
+    { "Globals", "Tree", "Tessellation", "Geometry", "ExtraGeometry" };
+
 void iPRCFile::dumpSections(string prefix)
 {
   ofstream out;
 
+  inflateAll();
   for(unsigned int i = 0; i < fileStructures.size(); ++i)
   {
     ostringstream name;
     name << prefix << "Structure" << i;
 
-    out.open((name.str()+"-Globals.bin").c_str());
-    out.write(fileStructures[i].sections[GLOBALS_SECTION],fileStructures[i].sectionLengths[GLOBALS_SECTION]);
-    out.close();
+    for(unsigned int j = 0; j < 5; ++j)
+    {
+      SectionData section = getSection(i,j);
+      out.open((name.str()+"-"+sectionNames[j]+".bin").c_str());
+      out.write(section.data.get(),section.length);
+      out.close();
+    }
+  }
+  SectionData modelFile = getModelFile();
+  out.open((prefix+"-ModelFile.bin").c_str());
+  out.write(modelFile.data.get(),modelFile.length);
+  out.close();
+}
+
+uint64_t hashData(const char *data, uint64_t length)
+{
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for(uint64_t i = 0; i < length; ++i)
+  {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+void iPRCFile::describe()
+{
+  OutputSink output(cout);
+  TextEmitter emitter(output);
+  describe(emitter);
+}
 
-    out.open((name.str()+"-Tree.bin").c_str());
-    out.write(fileStructures[i].sections[TREE_SECTION],fileStructures[i].sectionLengths[TREE_SECTION]);
-    out.close();
+// in the order of the sections in a file structure
+static void (PRCDescriber::*const describeFunctions[])(BitByBitData&) = {
+  &PRCDescriber::describeGlobals,
+  &PRCDescriber::describeTree,
+  &PRCDescriber::describeTessellation,
+  &PRCDescriber::describeGeometry,
+  &PRCDescriber::describeExtraGeometry
+};
 
-    out.open((name.str()+"-Tessellation.bin").c_str());
-    out.write(fileStructures[i].sections[TESSELLATION_SECTION],fileStructures[i].sectionLengths[TESSELLATION_SECTION]);
-    out.close();
+void iPRCFile::describeHeader(DescribeEmitter &emitter)
+{
+  emitter.fileHeaderField("Version for reading ",versionForRead);
+  emitter.fileHeaderField("Authoring version ",authoringVersion);
+  emitter.fileHeaderUUID("File structure UUID ",fileStructureUUID);
+  emitter.fileHeaderUUID("Application UUID ",applicationUUID);
+  emitter.fileHeaderField("number of file structures ",
+      static_cast<unsigned int>(fileStructureInfos.size()));
+  emitter.indent();
+  for(unsigned int i = 0; i < fileStructureInfos.size(); ++i)
+  {
+    const FileStructureInformation &info = fileStructureInfos[i];
+    emitter.fileHeaderUUID("File structure UUID ",info.UUID);
+    emitter.fileHeaderField("Reserved ",info.reserved);
+    emitter.fileHeaderField("Number of Offsets ",
+        static_cast<unsigned int>(info.offsets.size()));
+    emitter.indent();
+    for(unsigned int j = 0; j < info.offsets.size(); ++j)
+      emitter.fileHeaderField("Offset ",static_cast<unsigned int>(info.offsets[j]));
+    emitter.dedent();
+  }
+  emitter.dedent();
+  emitter.fileHeaderField("Model file offset ",static_cast<unsigned int>(modelFileOffset));
+  emitter.fileHeaderField("File size ",storedFileSize);
+  emitter.fileHeaderField("Number of uncompressed files ",numberOfUncompressedFiles);
+}
 
-    out.open((name.str()+"-Geometry.bin").c_str());
-    out.write(fileStructures[i].sections[GEOMETRY_SECTION],fileStructures[i].sectionLengths[GEOMETRY_SECTION]);
-    out.close();
+bool iPRCFile::describeFileStructureHeader(DescribeEmitter &emitter,
+                                          unsigned int i)
+{
+  emitter.fileStructure(i);
 
-    out.open((name.str()+"-ExtraGeometry.bin").c_str());
-    out.write(fileStructures[i].sections[EXTRA_GEOMETRY_SECTION],fileStructures[i].sectionLengths[EXTRA_GEOMETRY_SECTION]);
-    out.close();
+  //describe header
+  uint64_t position = fileStructureInfos[i].offsets[0];
+  char signature[3];
+  unsigned int minimalVersion, authoringVersion;
+  unsigned int fileStructureUUID[4], applicationUUID[4];
+  if(!read(position,signature,sizeof(signature)) ||
+     !read(position,&minimalVersion,sizeof(minimalVersion)) ||
+     !read(position,&authoringVersion,sizeof(authoringVersion)) ||
+     !read(position,fileStructureUUID,sizeof(fileStructureUUID)) ||
+     !read(position,applicationUUID,sizeof(applicationUUID)))
+    return false;
+  emitter.entity("Header Section");
+  emitter.indent();
+  emitter.text("Signature ",string(signature,3),false);
+  emitter.field("Minimal version for read ",minimalVersion);
+  emitter.field("Authoring version ",authoringVersion);
+  emitter.structureHeaderUUID("File structure UUID ",fileStructureUUID);
+  emitter.structureHeaderUUID("Application UUID ",applicationUUID);
+  emitter.dedent();
+  // uncompressed files
+  unsigned int numberOfUncompressedFiles;
+  if(!read(position,&numberOfUncompressedFiles,sizeof(numberOfUncompressedFiles)))
+    return false;
+  emitter.field("Number of uncompressed files ",numberOfUncompressedFiles);
+  for(unsigned int j = 0; j < numberOfUncompressedFiles; ++j)
+  {
+    unsigned int size;
+    if(!read(position,&size,sizeof(size)))
+      return false;
+    emitter.note(("Uncompressed file " + std::to_string(j) + ":").c_str());
+    emitter.indent();
+    emitter.field("size ",size," bytes");
+    emitter.dedent();
+    position += size;
   }
-  out.open((prefix+"-ModelFile.bin").c_str());
-  out.write(modelFileData,modelFileLength);
-  out.close();
+  return true;
 }
 
-void iPRCFile::describe()
+// Each file structure has six parts, its header and its five sections,
+// and the model file is the last part.
+string iPRCFile::partName(unsigned int part) const
+{
+  unsigned int i = part/6, section = part%6;
+  if(i == fileStructures.size())
+    return "ModelFile";
+  ostringstream name;
+  name << "Structure" << i << '-'
+       << (section == 0 ? "Header" : sectionNames[section-1]);
+  return name.str();
+}
+
+SectionData iPRCFile::getPartData(unsigned int part)
+{
+  unsigned int i = part/6, section = part%6;
+  if(i == fileStructures.size())
+    return getModelFile();
+  if(section == 0)
+    return SectionData();
+  return getSection(i,section-1);
+}
+
+bool iPRCFile::describePart(DescribeEmitter &emitter, unsigned int part)
+{
+  unsigned int i = part/6, section = part%6;
+  PRCDescriber describer(emitter);
+  if(i == fileStructures.size())
+  {
+    SectionData modelFile = getModelFile();
+    BitByBitData mfd(modelFile.data.get(),modelFile.length);
+    emitter.setSource(&mfd);
+    describer.describeSchema(mfd);
+    describer.describeModelFileData(mfd,fileStructures.size());
+    emitter.setSource(NULL);
+    return !mfd.readFailed();
+  }
+  if(section == 0)
+    return describeFileStructureHeader(emitter,i);
+  SectionData sectionData = getSection(i,section-1);
+  BitByBitData fileStruct(sectionData.data.get(),sectionData.length);
+  emitter.setSource(&fileStruct);
+  if(section-1 == GLOBALS_SECTION)
+    describer.describeSchema(fileStruct);
+  (describer.*describeFunctions[section-1])(fileStruct);
+  emitter.setSource(NULL);
+  return !fileStruct.readFailed();
+}
+
+bool iPRCFile::describe(DescribeEmitter &emitter)
 {
   /*
   for(int i = 0; i < modelFileLength; ++i)
@@ -75,146 +219,308 @@ void iPRCFile::describe()
   cout << endl;
   */
 
-  unFlushSerialization();
-  for(unsigned int i = 0; i < fileStructures.size(); ++i)
+  if(!valid)
+    return false;
+
+  describeHeader(emitter);
+
+  // The parts are described in parallel, each into its own buffer, and
+  // written in order. Only a few batches worth of output is held at once.
+  ThreadPool &pool = ThreadPool::global();
+  const unsigned int numberOfParts = getNumberOfParts();
+  const unsigned int batchSize = 2*pool.size();
+  vector<string> output;
+  vector<char> complete;
+  bool allComplete = true;
+  for(unsigned int first = 0; first < numberOfParts; first += batchSize)
   {
-    cout << "File Structure " << i << ":" << endl;
-
-    //describe header
-    char *header = buffer + fileStructureInfos[i].offsets[0];
-    cout << "--Header Section--" << endl;
-    cout << "  Signature " << header[0] << header[1] << header[2] << endl;
-    cout << "  Minimal version for read " << *(unsigned int*)(header+3) << endl;
-    cout << "  Authoring version " << *(unsigned int*)(header+7) << endl;
-    cout << std::hex;
-    cout << "  File structure UUID " << *(unsigned int*)(header+11) << ' ' << *(unsigned int*)(header+15) << ' ' 
-        << *(unsigned int*)(header+19) << ' ' << *(unsigned int*)(header+23) << endl;
-    cout << "  Application UUID " << *(unsigned int*)(header+27) << ' ' << *(unsigned int*)(header+31) << ' ' 
-        << *(unsigned int*)(header+35) << ' ' << *(unsigned int*)(header+39) << endl;
-    cout << std::dec;
-    // uncompressed files
-    unsigned int numberOfUncompressedFiles = *(unsigned int*)(header+43);
-    cout << "Number of uncompressed files " << numberOfUncompressedFiles << endl;
-    char *position = header+47;
-    for(unsigned int j = 0; j < numberOfUncompressedFiles; ++j)
+    unsigned int count = std::min(batchSize,numberOfParts-first);
+    output.assign(count,string());
+    complete.assign(count,true);
+    pool.parallelFor(count,[&](unsigned int p)
+    {
+      ostringstream text;
+      {
+        OutputSink sink(text,1<<16);
+        std::unique_ptr<DescribeEmitter> part(
+            emitter.createPart(sink,partName(first+p)));
+        complete[p] = describePart(*part,first+p);
+        part->flush();
+      }
+      output[p] = text.str();
+    });
+    for(unsigned int p = 0; p < count; ++p)
     {
-      cout << "Uncompressed file " << j << ":" << endl;
-      unsigned int size = *(unsigned int*)position;
-      cout << "  size " << size << " bytes" << endl;
-      position += size+sizeof(unsigned int);
+      emitter.append(output[p]);
+      allComplete = allComplete && complete[p];
     }
+  }
+  emitter.flush();
+  return allComplete;
+}
+
+iPRCFile::iPRCFile(istream& in) : data(NULL),fileSize(0),buffer(NULL),
+    mapping(NULL),valid(false),cachedBytes(0),sectionBudget(0),
+    sectionCache(NULL)
+{
+  //read the whole file into memory
+  in.seekg(0,ios::end);
+  std::streamoff length = in.tellg();
+  in.seekg(0,ios::beg);
+  if(length <= 0)
+  {
+    cerr << "Error: Cannot read input." << endl;
+    return;
+  }
+  fileSize = length;
+  buffer = (char*) malloc(fileSize);
+  in.read(buffer,fileSize);
+  data = buffer;
+  parse();
+}
 
-    BitByBitData fileStruct(fileStructures[i].sections[GLOBALS_SECTION],fileStructures[i].sectionLengths[GLOBALS_SECTION]);
-    describeSchema(fileStruct);
-    describeGlobals(fileStruct);
-    unFlushSerialization();
+iPRCFile::iPRCFile(const string& fileName) : data(NULL),fileSize(0),
+    buffer(NULL),mapping(NULL),valid(false),cachedBytes(0),sectionBudget(0),
+    sectionCache(NULL)
+{
+  mapping = new MappedFile(fileName);
+  if(!mapping->isOpen())
+  {
+    cerr << "Error: Cannot map input file " << fileName << "." << endl;
+    return;
+  }
+  data = mapping->getData();
+  fileSize = mapping->getSize();
+  parse();
+}
 
-    fileStruct = BitByBitData(fileStructures[i].sections[TREE_SECTION],fileStructures[i].sectionLengths[TREE_SECTION]);
-    describeTree(fileStruct);
-    unFlushSerialization();
+iPRCFile::iPRCFile(const char *d, uint64_t size, bool takeOwnership) :
+    data(d),fileSize(size),buffer(takeOwnership ? const_cast<char*>(d) : NULL),
+    mapping(NULL),valid(false),cachedBytes(0),sectionBudget(0),
+    sectionCache(NULL)
+{
+  if(size == 0)
+  {
+    cerr << "Error: Cannot read input." << endl;
+    return;
+  }
+  parse();
+}
+
+iPRCFile::~iPRCFile()
+{
+  free(buffer);
+  delete mapping;
+}
+
+SectionData iPRCFile::getSection(unsigned int fileStructure, unsigned int section)
+{
+  if(fileStructure >= fileStructureInfos.size() || section >= 5)
+    return SectionData();
+  return getSlot(5*fileStructure+section);
+}
 
-    fileStruct = BitByBitData(fileStructures[i].sections[TESSELLATION_SECTION],fileStructures[i].sectionLengths[TESSELLATION_SECTION]);
-    describeTessellation(fileStruct);
-    unFlushSerialization();
+SectionData iPRCFile::getModelFile()
+{
+  if(slots.empty())
+    return SectionData();
+  return getSlot(slots.size()-1);
+}
 
-    fileStruct = BitByBitData(fileStructures[i].sections[GEOMETRY_SECTION],fileStructures[i].sectionLengths[GEOMETRY_SECTION]);
-    describeGeometry(fileStruct);
-    unFlushSerialization();
+void iPRCFile::setSectionBudget(uint64_t bytes)
+{
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  sectionBudget = bytes;
+}
 
-    fileStruct = BitByBitData(fileStructures[i].sections[EXTRA_GEOMETRY_SECTION],fileStructures[i].sectionLengths[EXTRA_GEOMETRY_SECTION]);
-    describeExtraGeometry(fileStruct);
-    unFlushSerialization();
+SectionData iPRCFile::getSlot(unsigned int s)
+{
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    SectionSlot &slot = slots[s];
+    if(!slot.present)
+      return SectionData();
+    if(slot.cached)
+    {
+      recentlyUsed.splice(recentlyUsed.begin(),recentlyUsed,slot.lastUse);
+      return slot.section;
+    }
   }
+  // inflate without holding the lock, other sections stay accessible
+  SectionData section = inflateSlot(s);
+  cacheSlot(s,section);
+  return section;
+}
 
-  BitByBitData mfd(modelFileData,modelFileLength);
+SectionData iPRCFile::inflateSlot(unsigned int s)
+{
+  const uint64_t offset = slots[s].offset;
+  if(sectionCache != NULL)
+    return sectionCache->get(data+offset,slots[s].compressedLength);
+  SectionData section;
+  char *inflated = NULL;
+  section.length = decompress(data+offset,fileSize-offset,inflated);
+  section.data = std::shared_ptr<char>(inflated,free);
+  return section;
+}
 
-  describeSchema(mfd);
-  describeModelFileData(mfd,fileStructures.size());
-  unFlushSerialization();
+void iPRCFile::cacheSlot(unsigned int s, const SectionData& section)
+{
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  SectionSlot &slot = slots[s];
+  if(slot.cached) // another thread was faster
+    return;
+  slot.section = section;
+  slot.cached = true;
+  recentlyUsed.push_front(s);
+  slot.lastUse = recentlyUsed.begin();
+  cachedBytes += section.length;
+
+  // the section just added is kept even if it alone exceeds the budget
+  while(sectionBudget != 0 && cachedBytes > sectionBudget &&
+        recentlyUsed.size() > 1)
+  {
+    SectionSlot &coldest = slots[recentlyUsed.back()];
+    recentlyUsed.pop_back();
+    cachedBytes -= coldest.section.length;
+    coldest.section = SectionData();
+    coldest.cached = false;
+  }
 }
 
-iPRCFile::iPRCFile(istream& in)
+void iPRCFile::inflateAll()
 {
-  char PRC[3];
-  in.read(PRC,3);
-  if(PRC[0] != 'P' || PRC[1] != 'R' || PRC[2] != 'C')
+  vector<unsigned int> missing;
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if(sectionBudget != 0)
+      return;
+    for(unsigned int s = 0; s < slots.size(); ++s)
+      if(slots[s].present && !slots[s].cached)
+        missing.push_back(s);
+  }
+
+  //every section is an independent zlib stream, so inflate them all at once
+  vector<SectionData> sections(missing.size());
+  ThreadPool::global().parallelFor(missing.size(),[&](unsigned int m)
+  {
+    sections[m] = inflateSlot(missing[m]);
+  });
+  for(unsigned int m = 0; m < missing.size(); ++m)
+    cacheSlot(missing[m],sections[m]);
+}
+
+bool iPRCFile::read(uint64_t &position, void *value, uint64_t size)
+{
+  if(position+size > fileSize)
+  {
+    cerr << "Error: Unexpected end of file in header." << endl;
+    return false;
+  }
+  memcpy(value,data+position,size);
+  position += size;
+  return true;
+}
+
+void iPRCFile::parse()
+{
+  uint64_t position = 0;
+  if(fileSize < 3 || data[0] != 'P' || data[1] != 'R' || data[2] != 'C')
   {
     cerr << "Error: Invalid file format: PRC not found." << endl;
+    return;
   }
-  unsigned int versionForRead,authoringVersion;
-  in.read((char*)&versionForRead,sizeof(versionForRead));
-  in.read((char*)&authoringVersion,sizeof(authoringVersion));
-  cout << "Version for reading " << versionForRead << endl;
-  cout << "Authoring version " << authoringVersion << endl;
-  unsigned int fileStructureUUID[4];
-  in.read((char*)fileStructureUUID,sizeof(fileStructureUUID));
-  //(void*) is for formatting
-  cout << "File structure UUID " << (void*)(fileStructureUUID[0]) << ' ' << (void*)(fileStructureUUID[1]) << ' '
-      << (void*)(fileStructureUUID[2]) << ' ' << (void*)(fileStructureUUID[3]) << endl;
-  unsigned int applicationUUID[4];
-  in.read((char*)applicationUUID,sizeof(applicationUUID));
-  cout << "Application UUID " << (void*)(applicationUUID[0]) << ' ' << (void*)(applicationUUID[1]) << ' '
-      << (void*)(applicationUUID[2]) << ' ' << (void*)(applicationUUID[3]) << endl;
+  position = 3;
+  if(!read(position,&versionForRead,sizeof(versionForRead)) ||
+     !read(position,&authoringVersion,sizeof(authoringVersion)))
+    return;
+  if(!read(position,fileStructureUUID,sizeof(fileStructureUUID)))
+    return;
+  if(!read(position,applicationUUID,sizeof(applicationUUID)))
+    return;
   unsigned int numberOfFileStructures;
-  in.read((char*)&numberOfFileStructures,sizeof(numberOfFileStructures));
-  cout << "number of file structures " << numberOfFileStructures << endl;
+  if(!read(position,&numberOfFileStructures,sizeof(numberOfFileStructures)))
+    return;
 
   // load fileStructureInformation
   for(unsigned int fsi = 0; fsi < numberOfFileStructures; ++fsi)
   {
     FileStructureInformation info;
-    in.read((char*)&info.UUID,sizeof(info.UUID));
-    cout << "\tFile structure UUID " << (void*)(info.UUID[0]) << ' ' << (void*)(info.UUID[1]) << ' '
-        << (void*)(info.UUID[2]) << ' ' << (void*)(info.UUID[3]) << endl;
-
-    in.read((char*)&info.reserved,sizeof(info.reserved));
-    cout << "\tReserved " << info.reserved << endl;
-
+    if(!read(position,&info.UUID,sizeof(info.UUID)))
+      return;
+    if(!read(position,&info.reserved,sizeof(info.reserved)))
+      return;
     unsigned int numberOfOffsets;
-    in.read((char*)&numberOfOffsets,sizeof(numberOfOffsets));
-    cout << "\tNumber of Offsets " << numberOfOffsets << endl;
+    if(!read(position,&numberOfOffsets,sizeof(numberOfOffsets)))
+      return;
 
     for(unsigned int oi = 0; oi < numberOfOffsets; ++oi)
     {
+      // offsets are stored as 32 bit values
       unsigned int offset;
-      in.read((char*)&offset,sizeof(offset));
+      if(!read(position,&offset,sizeof(offset)))
+        return;
+      if(offset >= fileSize)
+      {
+        cerr << "Error: Section offset " << offset << " beyond end of file." << endl;
+        return;
+      }
       info.offsets.push_back(offset);
-      cout << "\t\tOffset " << offset << endl;
+    }
+    if(info.offsets.empty())
+    {
+      cerr << "Error: File structure without header." << endl;
+      return;
     }
     fileStructureInfos.push_back(info);
   }
-  in.read((char*)&modelFileOffset,sizeof(modelFileOffset));
-  cout << "Model file offset " << modelFileOffset << endl;
-  in.read((char*)&fileSize,sizeof(fileSize)); // this is not documented
-  cout << "File size " << fileSize << endl;
+  unsigned int offset;
+  if(!read(position,&offset,sizeof(offset)))
+    return;
+  modelFileOffset = offset;
+  if(modelFileOffset >= fileSize)
+  {
+    cerr << "Error: Model file offset beyond end of file." << endl;
+    return;
+  }
+  if(!read(position,&storedFileSize,sizeof(storedFileSize))) // this is not documented
+    return;
 
-  in.read((char*)&numberOfUncompressedFiles,sizeof(numberOfUncompressedFiles));
-  cout << "Number of uncompressed files " << numberOfUncompressedFiles << endl;
+  if(!read(position,&numberOfUncompressedFiles,sizeof(numberOfUncompressedFiles)))
+    return;
   for(unsigned int ufi = 0; ufi < numberOfUncompressedFiles; ++ufi)
   {
     unsigned int size;
-    in.read((char*)&size,sizeof(size));
-    in.seekg(size,ios::cur);
+    if(!read(position,&size,sizeof(size)))
+      return;
+    position += size;
   }
 
-  //read the whole file into memory
-  in.seekg(0,ios::beg);
-  buffer = new char[fileSize];
-  if(!buffer) cerr << "Couldn't get memory." << endl;
-  in.read(buffer,fileSize);
-  //decompress fileStructures
+  //locate the sections, they are inflated when first needed
+  fileStructures.resize(fileStructureInfos.size());
+  slots.resize(5*fileStructureInfos.size()+1);
   for(unsigned int fs = 0; fs < fileStructureInfos.size(); ++fs)
   {
-    fileStructures.push_back(FileStructure());
-    for(unsigned int i = 1; i < fileStructureInfos[fs].offsets.size(); ++i) // start at 1 since header is decompressed
+    // start at 1 since header is decompressed
+    for(unsigned int i = 1; i < fileStructureInfos[fs].offsets.size() && i <= 5; ++i)
     {
-      fileStructures[fs].sections[i-1] = NULL;
-      unsigned int offset = fileStructureInfos[fs].offsets[i];
-      fileStructures[fs].sectionLengths[i-1] = decompress(buffer+offset,fileSize-offset,fileStructures[fs].sections[i-1]);
+      slots[5*fs+i-1].present = true;
+      slots[5*fs+i-1].offset = fileStructureInfos[fs].offsets[i];
     }
   }
+  slots.back().present = true;
+  slots.back().offset = modelFileOffset;
 
-  //decompress modelFileData
-  modelFileData = NULL;
-  modelFileLength = decompress(buffer+modelFileOffset,fileSize-modelFileOffset,modelFileData);
+  // a section ends where the next thing in the file starts
+  vector<uint64_t> starts(1,fileSize);
+  starts.push_back(modelFileOffset);
+  for(unsigned int fs = 0; fs < fileStructureInfos.size(); ++fs)
+    starts.insert(starts.end(),fileStructureInfos[fs].offsets.begin(),
+                  fileStructureInfos[fs].offsets.end());
+  std::sort(starts.begin(),starts.end());
+  for(unsigned int s = 0; s < slots.size(); ++s)
+    if(slots[s].present)
+      slots[s].compressedLength = *std::upper_bound(starts.begin(),
+          starts.end()-1,slots[s].offset) - slots[s].offset;
+  valid = true;
 }
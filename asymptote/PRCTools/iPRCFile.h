@@ -27,14 +27,22 @@
 #include <vector>
 #include <sstream>
 #include <iomanip>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
 #include "PRC.h"
 #include "inflation.h"
+#include "mappedFile.h"
+
+class DescribeEmitter;
+class SectionCache;
 
 struct FileStructureInformation
 {
   unsigned int UUID[4];
   unsigned int reserved;
-  std::vector<unsigned int> offsets;
+  std::vector<uint64_t> offsets;
 };
 
 
@@ -50,39 +58,122 @@ struct FileStructure
   unsigned int authoringVersion;
   unsigned int fileUUID[4];
   unsigned int appUUID[4];
-  char* sections[5];
-  unsigned int sectionLengths[5];
+};
+
+// 64 bit FNV-1a of some bytes
+uint64_t hashData(const char *data, uint64_t length);
+
+// An inflated section. The data stays valid as long as a copy of this is
+// kept, even if the section is evicted from the cache of its iPRCFile.
+struct SectionData
+{
+  SectionData() : length(0) {}
+  std::shared_ptr<char> data;
+  uint64_t length;
 };
 
 class iPRCFile
 {
   public:
     iPRCFile(std::istream&);
+    // map the file read-only instead of copying it into memory
+    iPRCFile(const std::string& fileName);
+    // Parse data in place, without copying it. The caller keeps the data
+    // alive as long as the iPRCFile, unless takeOwnership is set: then it
+    // must have been allocated with malloc(), e.g. by decompress(), and
+    // is freed with the iPRCFile.
+    iPRCFile(const char *data,uint64_t size,bool takeOwnership = false);
+    ~iPRCFile();
 
-    ~iPRCFile()
+    bool isValid() const { return valid; }
+    uint64_t getFileSize() const { return fileSize; }
+    // hashData() of the whole file, to tell apart files of the same size
+    uint64_t getContentHash() const { return hashData(data,fileSize); }
+    unsigned int getNumberOfFileStructures() const
     {
-      for(unsigned int i = 0; i < fileStructures.size(); ++i)
-        for(unsigned int j = 0; j < 5; ++j)
-          if(fileStructures[i].sections[j] != NULL)
-            free(fileStructures[i].sections[j]);
-      if(modelFileData!=NULL)
-        free(modelFileData);
-      if(buffer != 0)
-        delete[] buffer;
+      return fileStructureInfos.size();
     }
 
-    void describe();
+    // Sections are inflated on first access. section is one of
+    // GLOBALS_SECTION ... EXTRA_GEOMETRY_SECTION.
+    SectionData getSection(unsigned int fileStructure, unsigned int section);
+    SectionData getModelFile();
+    // Evict the least recently used sections once more than this many
+    // inflated bytes are cached. 0 means no limit.
+    void setSectionBudget(uint64_t bytes);
+    // Inflate all sections that are not cached yet in parallel. Does
+    // nothing if a budget is set.
+    void inflateAll();
+    // Take inflated sections from a cache directory, and store those
+    // that are not there yet, instead of always inflating them. The cache
+    // may be shared by several files and must outlive them.
+    void setSectionCache(SectionCache *cache) { sectionCache = cache; }
+
+    void describe(); // as text to cout
+    // false if the file is invalid or a section ended before it was
+    // completely described
+    bool describe(DescribeEmitter&);
     void dumpSections(std::string);
 
+    // The parts that describe() writes one after another: the header and
+    // five sections of each file structure, then the model file. Parts
+    // can be described on several threads at once.
+    unsigned int getNumberOfParts() const
+    {
+      return 6*fileStructures.size()+1;
+    }
+    std::string partName(unsigned int) const;
+    // the inflated data of a part, empty for file structure headers
+    SectionData getPartData(unsigned int);
+    // false if the part ended before it was completely described
+    bool describePart(DescribeEmitter&,unsigned int);
+
   private:
+    void parse(); // read the header and locate the sections in data
+    void describeHeader(DescribeEmitter&);
+    bool describeFileStructureHeader(DescribeEmitter&,unsigned int);
+    bool read(uint64_t&,void*,uint64_t);
+
+    struct SectionSlot
+    {
+      SectionSlot() : present(false),offset(0),compressedLength(0),
+                      cached(false) {}
+      bool present; // the file has this section
+      uint64_t offset; // of the compressed data
+      uint64_t compressedLength; // up to whatever follows in the file
+      bool cached;
+      SectionData section;
+      std::list<unsigned int>::iterator lastUse;
+    };
+    SectionData getSlot(unsigned int);
+    SectionData inflateSlot(unsigned int);
+    void cacheSlot(unsigned int,const SectionData&);
+
     // header data
+    unsigned int versionForRead;
+    unsigned int authoringVersion;
+    unsigned int fileStructureUUID[4];
+    unsigned int applicationUUID[4];
+    unsigned int storedFileSize;
     std::vector<FileStructureInformation> fileStructureInfos;
     std::vector<FileStructure> fileStructures;
-    unsigned int modelFileOffset;
-    char* modelFileData;
-    unsigned int modelFileLength;
-    char *buffer;
-    unsigned int fileSize;
+    uint64_t modelFileOffset;
+    const char *data; // the whole file, either buffer or mapping
+    uint64_t fileSize;
+    char *buffer; // owned, allocated with malloc()
+    MappedFile *mapping;
     unsigned int numberOfUncompressedFiles;
+    bool valid;
+
+    // section cache: five slots per file structure, model file last
+    std::vector<SectionSlot> slots;
+    std::list<unsigned int> recentlyUsed; // most recent first
+    uint64_t cachedBytes;
+    uint64_t sectionBudget;
+    std::mutex cacheMutex;
+    SectionCache *sectionCache;
+
+    iPRCFile(const iPRCFile&);
+    void operator=(const iPRCFile&);
 };
 #endif // __READPRC_H
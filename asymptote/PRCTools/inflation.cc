@@ -18,6 +18,7 @@
 *
 *************/
 
+#include <algorithm>
 #include "inflation.h"
 
 using std::istream;
@@ -27,64 +28,80 @@ using std::cerr;
 using std::endl;
 using std::exit;
 
-int decompress(char* inb, int fileLength, char* &outb)
+uint64_t decompress(const char* inb, uint64_t fileLength, char* &outb)
 {
-  const int CHUNK = 16384;
-  unsigned int resultSize = 0;
+  const uint64_t CHUNK = 16384;
+  // zlib counts in uInt, so large buffers are handed over in pieces
+  const uint64_t MAX_STEP = 1UL << 30;
+  uint64_t resultSize = 0;
+  uint64_t size = CHUNK;
 
-  outb = (char*) realloc(outb,CHUNK);
+  outb = (char*) realloc(outb,size);
+  if(outb == NULL)
+  {
+    cerr << "Ran out of memory while decompressing." << endl;
+    exit(1);
+  }
   z_stream strm;
   strm.zalloc = Z_NULL;
   strm.zfree = Z_NULL;
-  strm.avail_in = fileLength;
-  strm.next_in = (unsigned char*)inb;
+  strm.avail_in = 0;
+  strm.next_in = Z_NULL;
   strm.opaque = Z_NULL;
   int code = inflateInit(&strm);
 
   if(code != Z_OK)
-    return -1;
-
-  strm.next_out = (unsigned char*)outb;
-  strm.avail_out = CHUNK;
-  code = inflate(&strm,Z_NO_FLUSH);
-  resultSize = CHUNK-strm.avail_out;
+    return 0;
 
-  unsigned int size = CHUNK;
+  const char *inEnd = inb + fileLength;
+  code = Z_OK;
   while(code == Z_OK)
   {
-    outb = (char*) realloc(outb,2*size);
-    if(outb == NULL)
+    if(resultSize == size)
     {
-      cerr << "Ran out of memory while decompressing." << endl;
-      exit(1);
+      outb = (char*) realloc(outb,2*size);
+      if(outb == NULL)
+      {
+        cerr << "Ran out of memory while decompressing." << endl;
+        exit(1);
+      }
+      size *= 2;
     }
+    if(strm.avail_in == 0 && inb != inEnd)
+    {
+      uint64_t step = std::min<uint64_t>(inEnd-inb,MAX_STEP);
+      strm.next_in = (Bytef*)inb;
+      strm.avail_in = step;
+      inb += step;
+    }
+    uint64_t step = std::min(size-resultSize,MAX_STEP);
     strm.next_out = (Bytef*)(outb + resultSize);
-    strm.avail_out += size;
-    size *= 2;
+    strm.avail_out = step;
     code = inflate(&strm,Z_NO_FLUSH);
-    resultSize = size - strm.avail_out;
+    resultSize += step - strm.avail_out;
   }
 
-  code = inflateEnd(&strm);
-  if(code != Z_OK)
+  // on damaged data, what was inflated up to the damage is kept
+  if(inflateEnd(&strm) != Z_OK)
   {
     free(outb);
+    outb = NULL;
     return 0;
   }
 
   return resultSize;
 }
 
-int decompress(istream &input,char* &result)
+uint64_t decompress(istream &input,char* &result)
 {
   input.seekg(0,ios::end);
-  int fileLength = input.tellg();
+  uint64_t fileLength = input.tellg();
   input.seekg(0,ios::beg);
 
   char *inb = new char[fileLength];
   input.read(inb,fileLength);
 
-  int code = decompress(inb,fileLength,result);
+  uint64_t code = decompress(inb,fileLength,result);
   delete[] inb;
   return code;
 }
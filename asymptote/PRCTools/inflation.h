@@ -23,9 +23,13 @@
 
 #include <iostream>
 #include <cstdlib>
+#include <stdint.h>
 #include <zlib.h>
 
-int decompress(std::istream&,char*&);
-int decompress(char*,int,char*&);
+// Inflate a zlib stream into a buffer allocated with realloc() and return
+// the number of bytes produced. Damaged data yields what was inflated
+// before the damage; 0 is returned only if zlib cannot be finished.
+uint64_t decompress(std::istream&,char*&);
+uint64_t decompress(const char*,uint64_t,char*&);
 
 #endif // __INFLATION_H
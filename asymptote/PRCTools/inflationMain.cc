@@ -37,11 +37,11 @@ int main(int argc, char *argv[])
   ifstream data(argv[1]);
 
   char *buff = NULL;
-  int dataSize = decompress(data,buff);
+  uint64_t dataSize = decompress(data,buff);
 
   cout << hex;
 
-  for(int i = 0; i < dataSize; ++i)
+  for(uint64_t i = 0; i < dataSize; ++i)
   {
     cout << ' ' << setw(2) << setfill('0')
         << static_cast<unsigned int>(static_cast<unsigned char>(buff[i]));
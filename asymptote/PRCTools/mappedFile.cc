@@ -0,0 +1,90 @@
+/************
+*
+*   This file is part of a tool for reading 3D content in the PRC format.
+*   Copyright (C) 2008 Orest Shardt <shardtor (at) gmail dot com>
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU Lesser General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU Lesser General Public License for more details.
+*
+*   You should have received a copy of the GNU Lesser General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*************/
+
+#include "mappedFile.h"
+
+#ifdef _WIN32
+# define NOMINMAX
+# include <windows.h>
+#else
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& fileName) : data(0),size(0),
+    fileHandle(INVALID_HANDLE_VALUE),mappingHandle(NULL)
+{
+  fileHandle = CreateFileA(fileName.c_str(),GENERIC_READ,FILE_SHARE_READ,
+                           NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+  if(fileHandle == INVALID_HANDLE_VALUE)
+    return;
+  LARGE_INTEGER fileSize;
+  if(!GetFileSizeEx(fileHandle,&fileSize) || fileSize.QuadPart == 0)
+    return;
+  mappingHandle = CreateFileMappingA(fileHandle,NULL,PAGE_READONLY,0,0,NULL);
+  if(mappingHandle == NULL)
+    return;
+  data = static_cast<const char*>(MapViewOfFile(mappingHandle,FILE_MAP_READ,0,0,0));
+  if(data != 0)
+    size = fileSize.QuadPart;
+}
+
+MappedFile::~MappedFile()
+{
+  if(data != 0)
+    UnmapViewOfFile(data);
+  if(mappingHandle != NULL)
+    CloseHandle(mappingHandle);
+  if(fileHandle != INVALID_HANDLE_VALUE)
+    CloseHandle(fileHandle);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& fileName) : data(0),size(0)
+{
+  int fd = open(fileName.c_str(),O_RDONLY);
+  if(fd < 0)
+    return;
+  struct stat info;
+  if(fstat(fd,&info) == 0 && info.st_size > 0)
+  {
+    void *mapping = mmap(NULL,info.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    if(mapping != MAP_FAILED)
+    {
+      data = static_cast<const char*>(mapping);
+      size = info.st_size;
+    }
+  }
+  // the mapping stays valid after the descriptor is closed
+  close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+  if(data != 0)
+    munmap(const_cast<char*>(data),size);
+}
+
+#endif
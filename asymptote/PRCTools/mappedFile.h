@@ -0,0 +1,50 @@
+/************
+*
+*   This file is part of a tool for reading 3D content in the PRC format.
+*   Copyright (C) 2008 Orest Shardt <shardtor (at) gmail dot com>
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU Lesser General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU Lesser General Public License for more details.
+*
+*   You should have received a copy of the GNU Lesser General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*************/
+
+#ifndef __MAPPEDFILE_H
+#define __MAPPEDFILE_H
+
+#include <string>
+#include <stdint.h>
+
+// Read-only memory mapping of a whole file.
+class MappedFile
+{
+  public:
+    MappedFile(const std::string& fileName);
+    ~MappedFile();
+
+    bool isOpen() const { return data != 0; }
+    const char* getData() const { return data; }
+    uint64_t getSize() const { return size; }
+
+  private:
+    const char *data;
+    uint64_t size;
+#ifdef _WIN32
+    void *fileHandle;
+    void *mappingHandle;
+#endif
+
+    MappedFile(const MappedFile&);
+    void operator=(const MappedFile&);
+};
+
+#endif // __MAPPEDFILE_H
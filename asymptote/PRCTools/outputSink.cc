@@ -0,0 +1,120 @@
+/************
+*
+*   This file is part of a tool for reading 3D content in the PRC format.
+*   Copyright (C) 2008 Orest Shardt <shardtor (at) gmail dot com>
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU Lesser General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU Lesser General Public License for more details.
+*
+*   You should have received a copy of the GNU Lesser General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*************/
+
+#include <algorithm>
+#include <charconv>
+#include "outputSink.h"
+
+using std::to_chars; using std::to_chars_result;
+
+// longest formatted number: a double in %g style or a 64 bit integer
+const size_t MAX_NUMBER_LENGTH = 32;
+
+OutputSink::OutputSink(std::ostream &o, size_t capacity) : out(&o),
+    buffer(capacity < MAX_NUMBER_LENGTH ? MAX_NUMBER_LENGTH : capacity),used(0)
+{
+}
+
+OutputSink::~OutputSink()
+{
+  flush();
+}
+
+void OutputSink::setStream(std::ostream &o)
+{
+  flush();
+  out = &o;
+}
+
+void OutputSink::flushBuffer()
+{
+  out->write(&buffer[0],used);
+  used = 0;
+}
+
+void OutputSink::flush()
+{
+  flushBuffer();
+  out->flush();
+}
+
+OutputSink& OutputSink::write(const char *s, size_t length)
+{
+  while(length > 0)
+  {
+    if(used == buffer.size())
+      flushBuffer();
+    size_t n = std::min(length,buffer.size()-used);
+    memcpy(&buffer[used],s,n);
+    used += n;
+    s += n;
+    length -= n;
+  }
+  return *this;
+}
+
+char* OutputSink::reserve(size_t length)
+{
+  if(buffer.size()-used < length)
+    flushBuffer();
+  return &buffer[used];
+}
+
+OutputSink& OutputSink::commit(char *last)
+{
+  used = last-&buffer[0];
+  return *this;
+}
+
+// shared by all integer types
+#define WRITE_NUMBER(value) \
+  char *first = reserve(MAX_NUMBER_LENGTH); \
+  return commit(to_chars(first,first+MAX_NUMBER_LENGTH,value).ptr);
+
+OutputSink& OutputSink::operator<<(int value) { WRITE_NUMBER(value) }
+OutputSink& OutputSink::operator<<(unsigned int value) { WRITE_NUMBER(value) }
+OutputSink& OutputSink::operator<<(long value) { WRITE_NUMBER(value) }
+OutputSink& OutputSink::operator<<(unsigned long value) { WRITE_NUMBER(value) }
+OutputSink& OutputSink::operator<<(long long value) { WRITE_NUMBER(value) }
+OutputSink& OutputSink::operator<<(unsigned long long value) { WRITE_NUMBER(value) }
+
+OutputSink& OutputSink::operator<<(double value)
+{
+  // same as the default precision of std::ostream
+  char *first = reserve(MAX_NUMBER_LENGTH);
+  return commit(to_chars(first,first+MAX_NUMBER_LENGTH,value,
+                         std::chars_format::general,6).ptr);
+}
+
+OutputSink& OutputSink::writeExact(double value)
+{
+  char *first = reserve(MAX_NUMBER_LENGTH);
+  return commit(to_chars(first,first+MAX_NUMBER_LENGTH,value).ptr);
+}
+
+OutputSink& OutputSink::writeHex(unsigned int value, unsigned int width,
+                                 char fill)
+{
+  char digits[8];
+  to_chars_result result = to_chars(digits,digits+8,value,16);
+  for(unsigned int length = result.ptr-digits; length < width; ++length)
+    *this << fill;
+  return write(digits,result.ptr-digits);
+}
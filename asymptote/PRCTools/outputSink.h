@@ -0,0 +1,81 @@
+/************
+*
+*   This file is part of a tool for reading 3D content in the PRC format.
+*   Copyright (C) 2008 Orest Shardt <shardtor (at) gmail dot com>
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU Lesser General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU Lesser General Public License for more details.
+*
+*   You should have received a copy of the GNU Lesser General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*************/
+
+#ifndef __OUTPUTSINK_H
+#define __OUTPUTSINK_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+
+// Text output through one large buffer. Numbers are formatted with
+// std::to_chars and look like the default formatting of std::ostream.
+// Nothing is flushed until the buffer is full or flush() is called.
+class OutputSink
+{
+  public:
+    OutputSink(std::ostream&,size_t capacity = 1 << 20);
+    ~OutputSink();
+
+    void setStream(std::ostream&); // flushes first
+    void flush();
+
+    OutputSink& operator<<(const char *s) { return write(s,strlen(s)); }
+    OutputSink& operator<<(const std::string &s)
+    {
+      return write(s.data(),s.size());
+    }
+    OutputSink& operator<<(char c)
+    {
+      if(used == buffer.size())
+        flushBuffer();
+      buffer[used++] = c;
+      return *this;
+    }
+    OutputSink& operator<<(bool b) { return *this << (b?'1':'0'); }
+    OutputSink& operator<<(int);
+    OutputSink& operator<<(unsigned int);
+    OutputSink& operator<<(long);
+    OutputSink& operator<<(unsigned long);
+    OutputSink& operator<<(long long);
+    OutputSink& operator<<(unsigned long long);
+    OutputSink& operator<<(double);
+
+    // lower case hexadecimal, padded with fill to at least width digits
+    OutputSink& writeHex(unsigned int,unsigned int width = 0,char fill = '0');
+    // the shortest text that reads back as the same double
+    OutputSink& writeExact(double);
+    OutputSink& write(const char*,size_t);
+
+  private:
+    char* reserve(size_t); // make room for a number
+    OutputSink& commit(char*); // finish a number started by reserve()
+    void flushBuffer();
+
+    std::ostream *out;
+    std::vector<char> buffer;
+    size_t used;
+
+    OutputSink(const OutputSink&);
+    void operator=(const OutputSink&);
+};
+
+#endif // __OUTPUTSINK_H
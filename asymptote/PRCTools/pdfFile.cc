@@ -0,0 +1,566 @@
+/************
+*
+*   This file is part of a tool for reading 3D content in the PRC format.
+*   Copyright (C) 2008 Orest Shardt <shardtor (at) gmail dot com>
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU Lesser General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU Lesser General Public License for more details.
+*
+*   You should have received a copy of the GNU Lesser General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*************/
+
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+#include <fstream>
+#include <set>
+#include "pdfFile.h"
+#include "iPRCFile.h"
+#include "inflation.h"
+
+using std::string; using std::vector; using std::set;
+using std::cerr; using std::endl;
+
+// the header may follow up to this much junk
+const uint64_t HEADER_SEARCH_LENGTH = 1024;
+// how far back from a /PRC to look for the start of its object
+const uint64_t OBJECT_SEARCH_LENGTH = 65536;
+// deeper nesting is taken as a broken file
+const unsigned int MAX_NESTING = 64;
+
+static bool isSpace(char c)
+{
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' ||
+      c == '\0';
+}
+
+static bool isDelimiter(char c)
+{
+  return strchr("()<>[]{}/%",c) != NULL && c != '\0';
+}
+
+static bool isRegular(char c)
+{
+  return !isSpace(c) && !isDelimiter(c);
+}
+
+static const char* findHeader(const char *data, uint64_t size)
+{
+  static const char header[] = "%PDF-";
+  const char *end = data+std::min(size,HEADER_SEARCH_LENGTH);
+  const char *found = std::search(data,end,header,header+5);
+  return found == end ? NULL : found;
+}
+
+bool PDFFile::isPDF(const char *data, uint64_t size)
+{
+  return findHeader(data,size) != NULL;
+}
+
+PDFFile::PDFFile(const string& fileName) : mapping(fileName),data(NULL),
+    size(0),valid(false)
+{
+  if(!mapping.isOpen())
+  {
+    cerr << "Error: Cannot map input file " << fileName << "." << endl;
+    return;
+  }
+  // offsets in the file count from the header
+  data = findHeader(mapping.getData(),mapping.getSize());
+  if(data == NULL)
+  {
+    cerr << "Error: " << fileName << " is not a PDF file." << endl;
+    return;
+  }
+  size = mapping.getSize()-(data-mapping.getData());
+  valid = true;
+
+  if(readCrossReferences())
+  {
+    for(std::map<uint64_t,uint64_t>::const_iterator it =
+        objectOffsets.begin(); it != objectOffsets.end(); ++it)
+      addIfPRC(it->second);
+  }
+  // wrong offsets are common enough to look again if nothing was found
+  if(valid && streams.empty())
+    scanForPRC();
+}
+
+uint64_t PDFFile::inflatePRCStream(unsigned int i, char* &buffer) const
+{
+  if(i >= streams.size())
+    return 0;
+  const Stream &stream = streams[i];
+  if(stream.deflated)
+    return decompress(data+stream.start,stream.length,buffer);
+  if(stream.length == 0)
+    return 0;
+  char *copy = (char*) realloc(buffer,stream.length);
+  if(copy == NULL)
+    return 0;
+  buffer = copy;
+  memcpy(buffer,data+stream.start,stream.length);
+  return stream.length;
+}
+
+// Read the cross-reference tables, newest first. False if there are
+// none in the classic format.
+bool PDFFile::readCrossReferences()
+{
+  static const char keyword[] = "startxref";
+  const uint64_t tail = std::min<uint64_t>(size,HEADER_SEARCH_LENGTH);
+  const char *found = std::find_end(data+size-tail,data+size,keyword,
+                                    keyword+9);
+  if(found == data+size)
+    return false;
+  uint64_t pos = found-data+9;
+  uint64_t offset;
+  if(!readNumber(pos,offset))
+    return false;
+
+  set<uint64_t> visited;
+  while(offset < size && visited.insert(offset).second)
+  {
+    pos = offset;
+    if(!readKeyword(pos,"xref"))
+      return false; // a cross-reference stream
+    uint64_t first, count;
+    while(readNumber(pos,first) && readNumber(pos,count))
+    {
+      for(uint64_t i = 0; i < count; ++i)
+      {
+        uint64_t objectOffset, generation;
+        if(!readNumber(pos,objectOffset) || !readNumber(pos,generation))
+          return false;
+        skipSpace(pos);
+        if(pos >= size)
+          return false;
+        // sections read later are older, the first offset seen is used
+        if(data[pos] == 'n' && objectOffset > 0 && objectOffset < size)
+          objectOffsets.insert(std::make_pair(first+i,objectOffset));
+        ++pos;
+      }
+    }
+    Dictionary trailer;
+    if(!readKeyword(pos,"trailer") || !readDictionary(pos,trailer))
+      return false;
+    if(trailer.count("Encrypt"))
+    {
+      cerr << "Error: Encrypted PDF files are not supported." << endl;
+      valid = false;
+      return false;
+    }
+    Dictionary::const_iterator previous = trailer.find("Prev");
+    if(previous == trailer.end() || previous->second.kind != Value::NUMBER)
+      break;
+    offset = previous->second.number;
+  }
+  return !objectOffsets.empty();
+}
+
+// Look at every /PRC in the file and parse the object it is in.
+void PDFFile::scanForPRC()
+{
+  static const char pattern[] = "/PRC";
+  const std::boyer_moore_horspool_searcher<const char*>
+      searcher(pattern,pattern+4);
+  for(const char *found = std::search(data,data+size,searcher);
+      found != data+size; found = std::search(found+4,data+size,searcher))
+  {
+    if(found+4 < data+size && isRegular(found[4]))
+      continue; // e.g. /PRCx
+    // the closest "obj" before it, then back over "n g "
+    const char *low = found-std::min<uint64_t>(found-data,
+                                               OBJECT_SEARCH_LENGTH);
+    const char *p = found-3;
+    while(p > low && !(memcmp(p,"obj",3) == 0 && isSpace(p[-1])))
+      --p;
+    if(p <= low)
+      continue;
+    for(unsigned int i = 0; i < 2; ++i)
+    {
+      while(p > data && isSpace(p[-1]))
+        --p;
+      while(p > data && p[-1] >= '0' && p[-1] <= '9')
+        --p;
+    }
+    addIfPRC(p-data);
+  }
+}
+
+void PDFFile::addIfPRC(uint64_t objectOffset)
+{
+  uint64_t pos = objectOffset;
+  Dictionary dictionary;
+  if(!readObjectHeader(pos) || !readDictionary(pos,dictionary))
+    return;
+  Dictionary::const_iterator subtype = dictionary.find("Subtype");
+  if(subtype == dictionary.end() || subtype->second.kind != Value::NAME ||
+     subtype->second.name != "PRC")
+    return;
+  if(!readKeyword(pos,"stream"))
+    return;
+  // the data starts after the end of the line
+  if(pos < size && data[pos] == '\r')
+    ++pos;
+  if(pos < size && data[pos] == '\n')
+    ++pos;
+
+  Stream stream;
+  stream.start = pos;
+  for(unsigned int i = 0; i < streams.size(); ++i)
+    if(streams[i].start == stream.start)
+      return; // found twice
+
+  // trust /Length only if endstream follows
+  Dictionary::const_iterator length = dictionary.find("Length");
+  uint64_t value;
+  stream.length = 0;
+  if(length != dictionary.end() && resolveLength(length->second,value) &&
+     value <= size-pos)
+  {
+    uint64_t after = pos+value;
+    if(readKeyword(after,"endstream"))
+      stream.length = value;
+  }
+  if(stream.length == 0)
+  {
+    uint64_t endOfStream = findEndOfStream(pos);
+    if(endOfStream == 0)
+      return;
+    stream.length = endOfStream-pos;
+  }
+
+  Dictionary::const_iterator filter = dictionary.find("Filter");
+  stream.deflated = false;
+  if(filter != dictionary.end())
+  {
+    const Value &value = filter->second;
+    string name;
+    if(value.kind == Value::NAME)
+      name = value.name;
+    else if(value.kind == Value::ARRAY && value.names.size() == 1)
+      name = value.names[0];
+    else if(!(value.kind == Value::ARRAY && value.names.empty()))
+      name = "?";
+    if(name == "FlateDecode" || name == "Fl")
+      stream.deflated = true;
+    else if(!name.empty())
+    {
+      cerr << "Warning: Skipping a PRC stream with an unsupported filter."
+           << endl;
+      return;
+    }
+  }
+  streams.push_back(stream);
+}
+
+// the position of the end of line before "endstream" after start, 0 if
+// there is none
+uint64_t PDFFile::findEndOfStream(uint64_t start) const
+{
+  static const char keyword[] = "endstream";
+  const char *found = std::search(data+start,data+size,keyword,keyword+9);
+  if(found == data+size)
+    return 0;
+  uint64_t end = found-data;
+  if(end > start && data[end-1] == '\n')
+    --end;
+  if(end > start && data[end-1] == '\r')
+    --end;
+  return end;
+}
+
+bool PDFFile::resolveLength(const Value &value, uint64_t &length) const
+{
+  if(value.kind == Value::NUMBER)
+  {
+    length = value.number;
+    return true;
+  }
+  if(value.kind != Value::REFERENCE)
+    return false;
+  std::map<uint64_t,uint64_t>::const_iterator object =
+      objectOffsets.find(value.number);
+  if(object == objectOffsets.end())
+    return false;
+  uint64_t pos = object->second;
+  return readObjectHeader(pos) && readNumber(pos,length);
+}
+
+void PDFFile::skipSpace(uint64_t &pos) const
+{
+  while(pos < size)
+  {
+    if(data[pos] == '%')
+    {
+      while(pos < size && data[pos] != '\n' && data[pos] != '\r')
+        ++pos;
+    }
+    else if(isSpace(data[pos]))
+      ++pos;
+    else
+      break;
+  }
+}
+
+bool PDFFile::readKeyword(uint64_t &pos, const char *keyword) const
+{
+  uint64_t p = pos;
+  skipSpace(p);
+  size_t length = strlen(keyword);
+  if(length > size-p || memcmp(data+p,keyword,length) != 0)
+    return false;
+  p += length;
+  if(p < size && isRegular(data[p]))
+    return false;
+  pos = p;
+  return true;
+}
+
+bool PDFFile::readNumber(uint64_t &pos, uint64_t &number) const
+{
+  uint64_t p = pos;
+  skipSpace(p);
+  if(p >= size || data[p] < '0' || data[p] > '9')
+    return false;
+  number = 0;
+  for(; p < size && data[p] >= '0' && data[p] <= '9'; ++p)
+    number = 10*number + (data[p]-'0');
+  if(p < size && isRegular(data[p]))
+    return false; // e.g. a real number
+  pos = p;
+  return true;
+}
+
+bool PDFFile::readName(uint64_t &pos, string &name) const
+{
+  uint64_t p = pos;
+  skipSpace(p);
+  if(p >= size || data[p] != '/')
+    return false;
+  name.clear();
+  for(++p; p < size && isRegular(data[p]); ++p)
+  {
+    if(data[p] == '#' && p+2 < size)
+    {
+      name += static_cast<char>(strtol(string(data+p+1,2).c_str(),NULL,16));
+      p += 2;
+    }
+    else
+      name += data[p];
+  }
+  pos = p;
+  return true;
+}
+
+bool PDFFile::readValue(uint64_t &pos, Value &value) const
+{
+  skipSpace(pos);
+  if(pos >= size)
+    return false;
+  value = Value();
+  if(data[pos] == '/')
+  {
+    value.kind = Value::NAME;
+    return readName(pos,value.name);
+  }
+  if(data[pos] == '[')
+  {
+    value.kind = Value::ARRAY;
+    uint64_t p = pos+1;
+    while(true)
+    {
+      skipSpace(p);
+      if(p >= size)
+        return false;
+      if(data[p] == ']')
+        break;
+      string name;
+      if(readName(p,name))
+        value.names.push_back(name);
+      else if(!skipValue(p))
+        return false;
+    }
+    pos = p+1;
+    return true;
+  }
+  uint64_t p = pos;
+  if(readNumber(p,value.number))
+  {
+    // "n g R" is a reference
+    uint64_t q = p, generation;
+    if(readNumber(q,generation) && readKeyword(q,"R"))
+    {
+      value.kind = Value::REFERENCE;
+      pos = q;
+    }
+    else
+    {
+      value.kind = Value::NUMBER;
+      pos = p;
+    }
+    return true;
+  }
+  return skipValue(pos);
+}
+
+bool PDFFile::skipValue(uint64_t &pos) const
+{
+  // nested containers, innermost last
+  string open;
+  do
+  {
+    skipSpace(pos);
+    if(pos >= size || open.size() > MAX_NESTING)
+      return false;
+    const char c = data[pos];
+    if(c == '<' && pos+1 < size && data[pos+1] == '<')
+    {
+      open += '>';
+      pos += 2;
+    }
+    else if(c == '[')
+    {
+      open += ']';
+      ++pos;
+    }
+    else if((c == '>' && pos+1 < size && data[pos+1] == '>') || c == ']')
+    {
+      if(open.empty() || open[open.size()-1] != c)
+        return false;
+      open.erase(open.size()-1);
+      pos += c == '>' ? 2 : 1;
+    }
+    else if(c == '(')
+    {
+      // literal string, may contain balanced parentheses and escapes
+      unsigned int depth = 0;
+      for(; pos < size; ++pos)
+      {
+        if(data[pos] == '\\')
+          ++pos;
+        else if(data[pos] == '(')
+          ++depth;
+        else if(data[pos] == ')' && --depth == 0)
+          break;
+      }
+      if(pos >= size)
+        return false;
+      ++pos;
+    }
+    else if(c == '<')
+    {
+      const char *end = static_cast<const char*>(
+          memchr(data+pos,'>',size-pos));
+      if(end == NULL)
+        return false;
+      pos = end-data+1;
+    }
+    else if(c == '/')
+    {
+      string name;
+      readName(pos,name);
+    }
+    else if(isRegular(c))
+    {
+      while(pos < size && isRegular(data[pos]))
+        ++pos;
+    }
+    else
+      return false;
+  } while(!open.empty());
+  return true;
+}
+
+bool PDFFile::readDictionary(uint64_t &pos, Dictionary &dictionary) const
+{
+  uint64_t p = pos;
+  skipSpace(p);
+  if(size-p < 2 || data[p] != '<' || data[p+1] != '<')
+    return false;
+  p += 2;
+  while(true)
+  {
+    skipSpace(p);
+    if(size-p >= 2 && data[p] == '>' && data[p+1] == '>')
+      break;
+    string key;
+    Value value;
+    if(!readName(p,key) || !readValue(p,value))
+      return false;
+    dictionary[key] = value;
+  }
+  pos = p+2;
+  return true;
+}
+
+bool PDFFile::readObjectHeader(uint64_t &pos) const
+{
+  uint64_t number, generation;
+  return readNumber(pos,number) && readNumber(pos,generation) &&
+      readKeyword(pos,"obj");
+}
+
+PRCInput::PRCInput(const string& name) : fileName(name),pdf(NULL),
+    valid(false)
+{
+  char start[HEADER_SEARCH_LENGTH];
+  std::ifstream in(fileName.c_str(),std::ios::in | std::ios::binary);
+  if(!in)
+  {
+    cerr << "Error: Cannot open input file " << fileName << "." << endl;
+    return;
+  }
+  in.read(start,sizeof(start));
+  if(PDFFile::isPDF(start,in.gcount()))
+  {
+    pdf = new PDFFile(fileName);
+    valid = pdf->isValid();
+  }
+  else
+    valid = true;
+}
+
+PRCInput::~PRCInput()
+{
+  delete pdf;
+}
+
+unsigned int PRCInput::getNumberOfFiles() const
+{
+  if(!valid)
+    return 0;
+  return pdf ? pdf->getNumberOfPRCStreams() : 1;
+}
+
+string PRCInput::getName(unsigned int i) const
+{
+  return pdf ? fileName+'#'+std::to_string(i) : fileName;
+}
+
+iPRCFile* PRCInput::open(unsigned int i) const
+{
+  if(pdf == NULL)
+    return new iPRCFile(fileName);
+  char *buffer = NULL;
+  uint64_t length = pdf->inflatePRCStream(i,buffer);
+  if(length == 0)
+  {
+    cerr << "Error: Cannot inflate PRC stream " << i << " of " << fileName
+         << "." << endl;
+    free(buffer);
+    buffer = NULL;
+  }
+  return new iPRCFile(buffer,length,true);
+}
@@ -0,0 +1,121 @@
+/************
+*
+*   This file is part of a tool for reading 3D content in the PRC format.
+*   Copyright (C) 2008 Orest Shardt <shardtor (at) gmail dot com>
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU Lesser General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU Lesser General Public License for more details.
+*
+*   You should have received a copy of the GNU Lesser General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*************/
+
+#ifndef __PDFFILE_H
+#define __PDFFILE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <stdint.h>
+#include "mappedFile.h"
+
+class iPRCFile;
+
+// Finds the PRC streams (3D streams with /Subtype /PRC) of a PDF file.
+// The objects are located through the cross-reference tables; if those
+// are missing, broken or compressed into streams, the file is scanned
+// for /PRC instead.
+class PDFFile
+{
+  public:
+    PDFFile(const std::string& fileName);
+
+    bool isValid() const { return valid; }
+    unsigned int getNumberOfPRCStreams() const { return streams.size(); }
+    // Inflate a PRC stream into a buffer allocated with realloc() and
+    // return its size, 0 on error.
+    uint64_t inflatePRCStream(unsigned int,char*&) const;
+
+    // does the data start like a PDF file?
+    static bool isPDF(const char*,uint64_t);
+
+  private:
+    struct Stream
+    {
+      uint64_t start; // of the data after the stream keyword
+      uint64_t length;
+      bool deflated;
+    };
+    // what is known about a dictionary entry
+    struct Value
+    {
+      Value() : kind(OTHER),number(0) {}
+      enum { NAME, NUMBER, REFERENCE, ARRAY, OTHER } kind;
+      std::string name;
+      uint64_t number; // or object number of a reference
+      std::vector<std::string> names; // of an array
+    };
+    typedef std::map<std::string,Value> Dictionary;
+
+    bool readCrossReferences();
+    void scanForPRC();
+    void addIfPRC(uint64_t objectOffset);
+
+    // parsing, pos is moved past what was read
+    void skipSpace(uint64_t &pos) const;
+    bool readKeyword(uint64_t &pos,const char*) const;
+    bool readNumber(uint64_t &pos,uint64_t&) const;
+    bool readName(uint64_t &pos,std::string&) const;
+    bool readValue(uint64_t &pos,Value&) const;
+    bool skipValue(uint64_t &pos) const;
+    bool readDictionary(uint64_t &pos,Dictionary&) const;
+    bool readObjectHeader(uint64_t &pos) const; // "n g obj"
+    bool resolveLength(const Value&,uint64_t&) const;
+    uint64_t findEndOfStream(uint64_t start) const;
+
+    MappedFile mapping;
+    const char *data;
+    uint64_t size;
+    bool valid;
+    std::map<uint64_t,uint64_t> objectOffsets; // from the xref, by number
+    std::vector<Stream> streams;
+
+    PDFFile(const PDFFile&);
+    void operator=(const PDFFile&);
+};
+
+// The PRC data of an input file: the file itself if it is a PRC file,
+// or the PRC streams of a PDF file.
+class PRCInput
+{
+  public:
+    PRCInput(const std::string& fileName);
+    ~PRCInput();
+
+    bool isValid() const { return valid; }
+    bool isPDF() const { return pdf != NULL; }
+    unsigned int getNumberOfFiles() const;
+    // the file name, with #<n> added for the n-th PRC stream of a PDF
+    std::string getName(unsigned int) const;
+    // a new iPRCFile for the caller to delete, invalid if the PRC data
+    // cannot be read
+    iPRCFile* open(unsigned int) const;
+
+  private:
+    std::string fileName;
+    PDFFile *pdf;
+    bool valid;
+
+    PRCInput(const PRCInput&);
+    void operator=(const PRCInput&);
+};
+
+#endif // __PDFFILE_H
@@ -0,0 +1,172 @@
+/************
+*
+*   This file is part of a tool for reading 3D content in the PRC format.
+*   Copyright (C) 2008 Orest Shardt <shardtor (at) gmail dot com>
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU Lesser General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU Lesser General Public License for more details.
+*
+*   You should have received a copy of the GNU Lesser General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*************/
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include "sectionCache.h"
+
+using std::string; using std::vector;
+using std::cerr; using std::endl;
+namespace fs = std::filesystem;
+
+const char *const SECTION_EXTENSION = ".prcsec";
+
+SectionCache::SectionCache(const string &d, uint64_t m) : directory(d),
+    maxBytes(m),valid(false),totalBytes(0)
+{
+  std::error_code error;
+  fs::create_directories(directory,error);
+  if(error || !fs::is_directory(directory,error))
+  {
+    cerr << "Error: Cannot use cache directory " << directory << "." << endl;
+    return;
+  }
+  valid = true;
+  evict();
+}
+
+// hash of the compressed data, and its length
+string SectionCache::fileName(const char *compressed, uint64_t length) const
+{
+  const uint64_t hash = hashData(compressed,length);
+  std::ostringstream name;
+  name << directory << '/' << std::hex << std::setw(16) << std::setfill('0')
+       << hash << '-' << std::dec << length << SECTION_EXTENSION;
+  return name.str();
+}
+
+SectionData SectionCache::get(const char *compressed, uint64_t length)
+{
+  const string name = fileName(compressed,length);
+  MappedFile *mapping = new MappedFile(name);
+  SectionData section;
+  if(mapping->isOpen() && mapping->getSize() > 0)
+  {
+    // used now, for eviction
+    std::error_code error;
+    fs::last_write_time(name,fs::file_time_type::clock::now(),error);
+    section.length = mapping->getSize();
+    section.data = std::shared_ptr<char>(
+        const_cast<char*>(mapping->getData()),
+        [mapping](char*) { delete mapping; });
+    return section;
+  }
+  delete mapping;
+
+  char *inflated = NULL;
+  section.length = decompress(compressed,length,inflated);
+  section.data = std::shared_ptr<char>(inflated,free);
+  if(section.length > 0)
+    store(name,section);
+  return section;
+}
+
+// Write to a file of our own and rename it, so that nobody maps a
+// section that is only partly written.
+void SectionCache::store(const string &name, const SectionData &section)
+{
+  std::random_device random;
+  std::ostringstream temporary;
+  temporary << name << '.' << std::hex << random() << random() << ".tmp";
+  {
+    std::ofstream out(temporary.str().c_str(),
+                      std::ios::out | std::ios::binary);
+    out.write(section.data.get(),section.length);
+    if(!out)
+    {
+      out.close();
+      std::error_code error;
+      fs::remove(temporary.str(),error);
+      return;
+    }
+  }
+  std::error_code error;
+  fs::rename(temporary.str(),name,error);
+  if(error)
+  {
+    fs::remove(temporary.str(),error);
+    return;
+  }
+  // the directory is only scanned once the sections stored since the last
+  // scan make the cache too large
+  bool full;
+  {
+    std::lock_guard<std::mutex> lock(evictionMutex);
+    totalBytes += section.length;
+    full = totalBytes > maxBytes;
+  }
+  if(full)
+    evict();
+}
+
+// Remove the least recently used sections once the cache is larger than
+// maxBytes. It is trimmed to three quarters of maxBytes, so that it is
+// not scanned again for every section stored after it got full.
+void SectionCache::evict()
+{
+  std::lock_guard<std::mutex> lock(evictionMutex);
+  struct CachedSection
+  {
+    fs::path path;
+    uint64_t size;
+    fs::file_time_type lastUse;
+  };
+  vector<CachedSection> sections;
+  uint64_t total = 0;
+  std::error_code error;
+  for(fs::directory_iterator it(directory,error), end;
+      !error && it != end; it.increment(error))
+  {
+    if(it->path().extension() != SECTION_EXTENSION)
+      continue;
+    CachedSection cached;
+    cached.path = it->path();
+    cached.size = it->file_size(error);
+    cached.lastUse = it->last_write_time(error);
+    if(error)
+    {
+      error.clear();
+      continue; // removed by someone else
+    }
+    total += cached.size;
+    sections.push_back(cached);
+  }
+  if(total <= maxBytes)
+  {
+    totalBytes = total;
+    return;
+  }
+  std::sort(sections.begin(),sections.end(),
+            [](const CachedSection &a, const CachedSection &b)
+            { return a.lastUse < b.lastUse; });
+  // sections still mapped stay readable until they are unmapped
+  const uint64_t target = maxBytes - maxBytes/4;
+  for(unsigned int i = 0; i < sections.size() && total > target; ++i)
+  {
+    fs::remove(sections[i].path,error);
+    total -= sections[i].size;
+  }
+  totalBytes = total;
+}
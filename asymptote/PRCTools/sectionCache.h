@@ -0,0 +1,62 @@
+/************
+*
+*   This file is part of a tool for reading 3D content in the PRC format.
+*   Copyright (C) 2008 Orest Shardt <shardtor (at) gmail dot com>
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU Lesser General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU Lesser General Public License for more details.
+*
+*   You should have received a copy of the GNU Lesser General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*************/
+
+#ifndef __SECTIONCACHE_H
+#define __SECTIONCACHE_H
+
+#include <string>
+#include <mutex>
+#include <stdint.h>
+#include "iPRCFile.h"
+
+// Inflated sections kept as plain files in a directory, shared by all
+// files, threads and processes that use it. A section is found by a hash
+// of its compressed data, so a file that is opened again is not inflated
+// again; cached sections are memory-mapped. The least recently used
+// files are removed once the directory holds more than maxBytes, down to
+// three quarters of it.
+class SectionCache
+{
+  public:
+    SectionCache(const std::string &directory, uint64_t maxBytes);
+
+    bool isValid() const { return valid; }
+    // the inflated data of a compressed section, mapped from the cache or
+    // inflated and stored; empty if it cannot be inflated
+    SectionData get(const char *compressed, uint64_t length);
+
+  private:
+    std::string fileName(const char*,uint64_t) const;
+    void store(const std::string&,const SectionData&);
+    void evict();
+
+    std::string directory;
+    uint64_t maxBytes;
+    bool valid;
+    std::mutex evictionMutex;
+    // size of the sections at the last scan of the directory, and of
+    // those stored since; guarded by evictionMutex
+    uint64_t totalBytes;
+
+    SectionCache(const SectionCache&);
+    void operator=(const SectionCache&);
+};
+
+#endif // __SECTIONCACHE_H
@@ -0,0 +1,255 @@
+/************
+*
+*   This file is part of a tool for reading 3D content in the PRC format.
+*   Copyright (C) 2008 Orest Shardt <shardtor (at) gmail dot com>
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU Lesser General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU Lesser General Public License for more details.
+*
+*   You should have received a copy of the GNU Lesser General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*************/
+
+#include <cstring>
+#include <algorithm>
+#include "PRC.h"
+#include "tessellationEmitter.h"
+
+using std::string; using std::vector;
+
+// In the sizes of the fans and strips of the *OneNormal kinds: the whole
+// fan or strip has one normal.
+const unsigned int SINGLE_NORMAL = 0x40000000;
+const unsigned int SIZE_MASK = 0x3FFFFFFF;
+
+// the index of point number vertex of a triangle, fan or strip whose data
+// starts at first
+static bool pointIndex(const vector<unsigned int> &indices, uint64_t first,
+                       unsigned int vertex, unsigned int perVertex,
+                       unsigned int points, uint32_t &point)
+{
+  // the point index is the last index of each vertex
+  uint64_t i = first + (uint64_t)vertex*perVertex + perVertex-1;
+  if(i >= indices.size() || indices[i]/3 >= points)
+    return false;
+  point = indices[i]/3;
+  return true;
+}
+
+bool Tessellation3D::triangulate(vector<uint32_t> &triangles) const
+{
+  // the kinds of entities, in the order their data is stored
+  static const unsigned int kinds[] = {
+      PRC_FACETESSDATA_Triangle, PRC_FACETESSDATA_TriangleFan,
+      PRC_FACETESSDATA_TriangleStripe, PRC_FACETESSDATA_TriangleOneNormal,
+      PRC_FACETESSDATA_TriangleFanOneNormal,
+      PRC_FACETESSDATA_TriangleStripeOneNormal,
+      PRC_FACETESSDATA_TriangleTextured, PRC_FACETESSDATA_TriangleFanTextured,
+      PRC_FACETESSDATA_TriangleStripeTextured,
+      PRC_FACETESSDATA_TriangleOneNormalTextured,
+      PRC_FACETESSDATA_TriangleFanOneNormalTextured,
+      PRC_FACETESSDATA_TriangleStripeOneNormalTextured };
+  const unsigned int oneNormal = PRC_FACETESSDATA_TriangleOneNormal |
+      PRC_FACETESSDATA_TriangleFanOneNormal |
+      PRC_FACETESSDATA_TriangleStripeOneNormal |
+      PRC_FACETESSDATA_TriangleOneNormalTextured |
+      PRC_FACETESSDATA_TriangleFanOneNormalTextured |
+      PRC_FACETESSDATA_TriangleStripeOneNormalTextured;
+  const unsigned int fans = PRC_FACETESSDATA_TriangleFan |
+      PRC_FACETESSDATA_TriangleFanOneNormal |
+      PRC_FACETESSDATA_TriangleFanTextured |
+      PRC_FACETESSDATA_TriangleFanOneNormalTextured;
+  const unsigned int strips = PRC_FACETESSDATA_TriangleStripe |
+      PRC_FACETESSDATA_TriangleStripeOneNormal |
+      PRC_FACETESSDATA_TriangleStripeTextured |
+      PRC_FACETESSDATA_TriangleStripeOneNormalTextured;
+  const unsigned int texturedKinds = PRC_FACETESSDATA_TriangleTextured |
+      PRC_FACETESSDATA_TriangleFanTextured |
+      PRC_FACETESSDATA_TriangleStripeTextured |
+      PRC_FACETESSDATA_TriangleOneNormalTextured |
+      PRC_FACETESSDATA_TriangleFanOneNormalTextured |
+      PRC_FACETESSDATA_TriangleStripeOneNormalTextured;
+  const unsigned int polyfaces = PRC_FACETESSDATA_Polyface |
+      PRC_FACETESSDATA_PolyfaceOneNormal | PRC_FACETESSDATA_PolyfaceTextured |
+      PRC_FACETESSDATA_PolyfaceOneNormalTextured;
+
+  // Writers leave out the normal indices when there are no normals,
+  // e.g. when they must be recalculated.
+  const bool normals = numberOfNormalCoordinates > 0;
+  const unsigned int points = coordinates.size()/3;
+  bool understood = true;
+  for(unsigned int f = 0; f < faces.size(); ++f)
+  {
+    const TessellationFace &face = faces[f];
+    // The polyface data comes first, and the layout of its sizes is not
+    // known here, so the data of the other kinds cannot be found either.
+    if(face.usedEntities & polyfaces)
+    {
+      understood = false;
+      continue;
+    }
+    uint64_t next = face.startTriangulated;
+    unsigned int size = 0; // position in sizesTriangulated
+    bool faceOK = true;
+    for(unsigned int k = 0; k < sizeof(kinds)/sizeof(kinds[0]) && faceOK; ++k)
+    {
+      const unsigned int kind = kinds[k];
+      if(!(face.usedEntities & kind))
+        continue;
+      const bool perVertexNormal = normals && !(kind & oneNormal);
+      const bool textured = kind & texturedKinds;
+      const unsigned int perVertex = (perVertexNormal ? 1 : 0) +
+          (textured ? face.textureCoordinateIndexes : 0) + 1;
+      const unsigned int perShared = normals && (kind & oneNormal) ? 1 : 0;
+      if(size >= face.sizesTriangulated.size())
+      {
+        faceOK = false;
+        break;
+      }
+
+      if(!(kind & (fans | strips)))
+      {
+        const unsigned int count = face.sizesTriangulated[size++];
+        for(unsigned int t = 0; t < count && faceOK; ++t)
+        {
+          next += perShared;
+          uint32_t p[3];
+          for(unsigned int v = 0; v < 3 && faceOK; ++v)
+            faceOK = pointIndex(triangulatedIndices,next,v,perVertex,points,
+                                p[v]);
+          if(faceOK)
+            triangles.insert(triangles.end(),p,p+3);
+          next += 3*perVertex;
+        }
+        continue;
+      }
+
+      const unsigned int count = face.sizesTriangulated[size++];
+      for(unsigned int g = 0; g < count && faceOK; ++g)
+      {
+        if(size >= face.sizesTriangulated.size())
+        {
+          faceOK = false;
+          break;
+        }
+        const unsigned int entry = face.sizesTriangulated[size++];
+        const unsigned int vertices = entry & SIZE_MASK;
+        // one normal for all of the fan or strip, or one for each vertex
+        unsigned int stride = perVertex;
+        if(normals && (kind & oneNormal))
+        {
+          if(entry & SINGLE_NORMAL)
+            next += 1;
+          else
+            stride += 1;
+        }
+        uint32_t centre = 0, older = 0, newer = 0, current;
+        for(unsigned int v = 0; v < vertices && faceOK; ++v)
+        {
+          faceOK = pointIndex(triangulatedIndices,next,v,stride,points,current);
+          if(!faceOK)
+            break;
+          if(v >= 2)
+          {
+            uint32_t p[3] = { older, newer, current };
+            if(kind & fans)
+              p[0] = centre;
+            else if(v%2 == 1) // every other triangle of a strip is flipped
+              std::swap(p[0],p[1]);
+            triangles.insert(triangles.end(),p,p+3);
+          }
+          if(v == 0)
+            centre = current;
+          older = newer;
+          newer = current;
+        }
+        next += (uint64_t)vertices*stride;
+      }
+    }
+    understood = understood && faceOK;
+  }
+  return understood;
+}
+
+DescribeEmitter* TessellationEmitter::createPart(OutputSink &o,
+                                                 const string&) const
+{
+  return new TessellationEmitter(o);
+}
+
+bool TessellationEmitter::inTessellation() const
+{
+  return !entities.empty() && entities.back() == "3D Tessellation";
+}
+
+bool TessellationEmitter::inFace() const
+{
+  return !entities.empty() && entities.back() == "Tessellation Face" &&
+      !tessellations.empty();
+}
+
+void TessellationEmitter::entity(const char *type)
+{
+  if(strcmp(type,"3D Tessellation") == 0)
+    tessellations.push_back(Tessellation3D());
+  else if(strcmp(type,"Tessellation Face") == 0 && inTessellation())
+    tessellations.back().faces.push_back(TessellationFace());
+  entities.push_back(type);
+}
+
+void TessellationEmitter::endEntity()
+{
+  if(!entities.empty())
+    entities.pop_back();
+}
+
+void TessellationEmitter::field(const char *label, int value, const char*)
+{
+  if((strcmp(label,"has_location ") == 0 && value != 0) ||
+     (strcmp(label,"index_local_coordinate_system ") == 0 && value >= 0))
+    transformed = true;
+}
+
+void TessellationEmitter::field(const char *label, unsigned int value,
+                                const char*)
+{
+  if(inTessellation())
+  {
+    if(strcmp(label,"number_of_normal_coordinates ") == 0)
+      tessellations.back().numberOfNormalCoordinates = value;
+  }
+  else if(inFace())
+  {
+    TessellationFace &face = tessellations.back().faces.back();
+    if(strcmp(label,"start_triangulated ") == 0)
+      face.startTriangulated = value;
+    else if(strcmp(label,"used_entities_flag ") == 0)
+      face.usedEntities = value;
+    else if(strcmp(label,"number_of_texture_coordinate_indexes ") == 0)
+      face.textureCoordinateIndexes = value;
+  }
+}
+
+void TessellationEmitter::array(const char *name,
+                                const vector<double> &values)
+{
+  if(inTessellation() && strcmp(name,"coordinates") == 0)
+    tessellations.back().coordinates = values;
+}
+
+void TessellationEmitter::array(const char *name,
+                                const vector<unsigned int> &values)
+{
+  if(inTessellation() && strcmp(name,"triangulated_indices") == 0)
+    tessellations.back().triangulatedIndices = values;
+  else if(inFace() && strcmp(name,"sizes_triangulated") == 0)
+    tessellations.back().faces.back().sizesTriangulated = values;
+}
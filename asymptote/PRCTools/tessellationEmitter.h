@@ -0,0 +1,107 @@
+/************
+*
+*   This file is part of a tool for reading 3D content in the PRC format.
+*   Copyright (C) 2008 Orest Shardt <shardtor (at) gmail dot com>
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU Lesser General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU Lesser General Public License for more details.
+*
+*   You should have received a copy of the GNU Lesser General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*************/
+
+#ifndef __TESSELLATION_EMITTER_H
+#define __TESSELLATION_EMITTER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "describeEmitter.h"
+
+struct TessellationFace
+{
+  TessellationFace() : startTriangulated(0),usedEntities(0),
+                       textureCoordinateIndexes(0) {}
+  unsigned int startTriangulated;
+  unsigned int usedEntities; // PRC_FACETESSDATA_* flags
+  unsigned int textureCoordinateIndexes; // per vertex
+  std::vector<unsigned int> sizesTriangulated;
+};
+
+// A PRC_TYPE_TESS_3D tessellation as it is stored in the file.
+struct Tessellation3D
+{
+  Tessellation3D() : numberOfNormalCoordinates(0) {}
+
+  // Append the triangles of all faces to triangles, three point indices
+  // each, i.e. indices of x coordinates divided by 3. Triangle fans and
+  // strips are split into triangles. Faces with polyfaces are left out.
+  // Returns false if a face could not be understood; the triangles of the
+  // other faces are still added.
+  bool triangulate(std::vector<uint32_t> &triangles) const;
+
+  std::vector<double> coordinates; // x y z of each point
+  unsigned int numberOfNormalCoordinates;
+  std::vector<unsigned int> triangulatedIndices;
+  std::vector<TessellationFace> faces;
+};
+
+// Collects the 3D tessellations of a tessellation section that is being
+// described, e.g. by PRCDescriber::describeTessellation(). In a tree
+// section it notes whether anything is placed by a transformation, i.e.
+// product occurrences with a location or representation items with a
+// local coordinate system. Everything else is ignored.
+class TessellationEmitter : public DescribeEmitter
+{
+  public:
+    TessellationEmitter(OutputSink &o) : DescribeEmitter(o),
+                                         transformed(false) {}
+
+    DescribeEmitter* createPart(OutputSink&,const std::string&) const;
+
+    void entity(const char*);
+    void endEntity();
+    void field(const char*,unsigned int,const char* = NULL);
+    void array(const char*,const std::vector<double>&);
+    void array(const char*,const std::vector<unsigned int>&);
+
+    void beginFile(const std::string&) {}
+    void endFile(const std::string&,const char*) {}
+    void fileStructure(unsigned int) {}
+    void sectionCode(unsigned int,unsigned int) {}
+    void field(const char*,int,const char* = NULL);
+    void field(const char*,double,const char* = NULL) {}
+    void flag(const char*,bool) {}
+    void text(const char*,const std::string&,bool = true) {}
+    void coordinates(const char*,const double*,unsigned int) {}
+    void colour(double,double,double) {}
+    void row(const unsigned int*,unsigned int) {}
+    void uuid(const char*,const unsigned int[4]) {}
+    void userData(const std::string&) {}
+    void note(const char*) {}
+    void warning(const char*) {}
+    void position() {}
+    void blankLine() {}
+    void beginBitDump() {}
+    void dumpBit(bool) {}
+    void endBitDump() {}
+
+    std::vector<Tessellation3D> tessellations;
+    bool transformed;
+
+  private:
+    bool inTessellation() const;
+    bool inFace() const;
+
+    std::vector<std::string> entities; // not ended yet, innermost last
+};
+
+#endif // __TESSELLATION_EMITTER_H
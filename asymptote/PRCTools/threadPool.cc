@@ -0,0 +1,151 @@
+/************
+*
+*   This file is part of a tool for reading 3D content in the PRC format.
+*   Copyright (C) 2008 Orest Shardt <shardtor (at) gmail dot com>
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU Lesser General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU Lesser General Public License for more details.
+*
+*   You should have received a copy of the GNU Lesser General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*************/
+
+#include "threadPool.h"
+
+using std::mutex; using std::unique_lock; using std::shared_ptr;
+using std::function;
+
+ThreadPool::ThreadPool(unsigned int numberOfThreads) :
+    nextSequence(0),stopping(false)
+{
+  if(numberOfThreads == 0)
+    numberOfThreads = std::thread::hardware_concurrency();
+  // the caller of parallelFor() is the remaining thread
+  for(unsigned int i = 1; i < numberOfThreads; ++i)
+    workers.push_back(std::thread(&ThreadPool::work,this));
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    unique_lock<mutex> lock(jobsMutex);
+    stopping = true;
+  }
+  wakeUp.notify_all();
+  for(unsigned int i = 0; i < workers.size(); ++i)
+    workers[i].join();
+}
+
+ThreadPool& ThreadPool::global()
+{
+  static ThreadPool pool;
+  return pool;
+}
+
+bool ThreadPool::runOne(Job &job)
+{
+  unsigned int i = job.next++;
+  if(i >= job.count)
+    return false;
+  job.body(i);
+  if(++job.finished == job.count)
+  {
+    unique_lock<mutex> lock(jobsMutex);
+    jobDone.notify_all();
+  }
+  return true;
+}
+
+// The most recently added job with iterations left that was added after
+// job, which may have left the queue already. Jobs as old as job or
+// older are left alone: a thread helping while it waits only runs jobs
+// added after the one it waits for, such as those nested in it, so each
+// level of helping goes to a newer job and the depth stays bounded by
+// the jobs added meanwhile. jobsMutex must be locked.
+shared_ptr<ThreadPool::Job> ThreadPool::unclaimedJob(const shared_ptr<Job> &job)
+{
+  for(std::deque<shared_ptr<Job> >::reverse_iterator it = jobs.rbegin();
+      it != jobs.rend() && (*it)->sequence > job->sequence; ++it)
+    if((*it)->next < (*it)->count)
+      return *it;
+  return shared_ptr<Job>();
+}
+
+void ThreadPool::work()
+{
+  while(true)
+  {
+    shared_ptr<Job> job;
+    {
+      unique_lock<mutex> lock(jobsMutex);
+      while(!stopping && jobs.empty())
+        wakeUp.wait(lock);
+      if(stopping)
+        return;
+      job = jobs.front();
+      if(job->next >= job->count)
+      {
+        // every iteration has been claimed, let the others move on
+        jobs.pop_front();
+        continue;
+      }
+    }
+    runOne(*job);
+  }
+}
+
+void ThreadPool::parallelFor(unsigned int count,
+                             const function<void(unsigned int)>& body)
+{
+  if(count == 0)
+    return;
+  if(count == 1 || workers.empty())
+  {
+    for(unsigned int i = 0; i < count; ++i)
+      body(i);
+    return;
+  }
+
+  shared_ptr<Job> job(new Job(count,body));
+  {
+    unique_lock<mutex> lock(jobsMutex);
+    job->sequence = nextSequence++;
+    jobs.push_back(job);
+  }
+  wakeUp.notify_all();
+  jobDone.notify_all(); // callers waiting in parallelFor() can help too
+
+  while(runOne(*job))
+    ;
+
+  // Until the others finish the iterations they claimed, help with the
+  // jobs nested in them instead of sitting idle.
+  unique_lock<mutex> lock(jobsMutex);
+  while(job->finished < job->count)
+  {
+    shared_ptr<Job> other = unclaimedJob(job);
+    if(other)
+    {
+      lock.unlock();
+      runOne(*other);
+      lock.lock();
+    }
+    else
+      jobDone.wait(lock);
+  }
+  for(std::deque<shared_ptr<Job> >::iterator it = jobs.begin();
+      it != jobs.end(); ++it)
+    if(*it == job)
+    {
+      jobs.erase(it);
+      break;
+    }
+}
@@ -0,0 +1,78 @@
+/************
+*
+*   This file is part of a tool for reading 3D content in the PRC format.
+*   Copyright (C) 2008 Orest Shardt <shardtor (at) gmail dot com>
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU Lesser General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU Lesser General Public License for more details.
+*
+*   You should have received a copy of the GNU Lesser General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*************/
+
+#ifndef __THREADPOOL_H
+#define __THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads that run the iterations of parallelFor().
+// The calling thread works on its own job too, so nested and concurrent
+// calls cannot deadlock.
+class ThreadPool
+{
+  public:
+    ThreadPool(unsigned int numberOfThreads = 0); // 0: one per core
+    ~ThreadPool();
+
+    unsigned int size() const { return workers.size()+1; }
+
+    // call body(0) ... body(count-1) and return when all have finished
+    void parallelFor(unsigned int count,
+                     const std::function<void(unsigned int)>& body);
+
+    static ThreadPool& global();
+
+  private:
+    struct Job
+    {
+      Job(unsigned int c, const std::function<void(unsigned int)>& b) :
+          count(c),next(0),finished(0),body(b),sequence(0) {}
+      const unsigned int count;
+      std::atomic<unsigned int> next;
+      std::atomic<unsigned int> finished;
+      const std::function<void(unsigned int)>& body;
+      unsigned long long sequence; // order in which the jobs were added
+    };
+
+    bool runOne(Job&); // run one iteration, false if none left
+    std::shared_ptr<Job> unclaimedJob(const std::shared_ptr<Job>&);
+    void work();
+
+    std::vector<std::thread> workers;
+    std::deque<std::shared_ptr<Job> > jobs;
+    std::mutex jobsMutex;
+    std::condition_variable wakeUp;
+    std::condition_variable jobDone;
+    unsigned long long nextSequence;
+    bool stopping;
+
+    ThreadPool(const ThreadPool&);
+    void operator=(const ThreadPool&);
+};
+
+#endif // __THREADPOOL_H
@@ -34,6 +34,10 @@
 #include <stdexcept>
 #include <sstream>
 #include <algorithm>
+#include <map>
+#include <cmath>
+#include <thread>
+#include <unordered_map>
 
 #include <setjmp.h>
 #include "hpdf.h"
@@ -66,9 +70,36 @@ struct BoundingBox {
 struct Mesh {
     std::vector<float> pointArray;
     std::vector<unsigned long> facetArray;
+    std::vector<unsigned long> neighbourArray; // facet across each edge
+    std::vector<unsigned long> stripArray;     // points of all strips
+    std::vector<uint32_t> stripSizes;          // number of points per strip
     BoundingBox bbox;
 };
 
+// The diffuse colour and alpha of the meshes of one input file, alpha
+// below 0 to keep the default.
+struct MaterialOverride {
+    double red, green, blue, alpha;
+};
+
+// by file name, with or without the directories
+typedef std::map<std::string, MaterialOverride> MaterialManifest;
+
+struct Options {
+    bool direct;      // write the tessellation without PRC3DTess objects
+    double weldTolerance; // weld points closer than this, 0 to keep all
+    bool strips;      // join the triangles to strips
+    bool reorder;     // sort points and facets for locality
+    double grid;      // round coordinates to a grid this fine, 0 for none
+    int bits;         // round coordinates to this many significant bits, 0 for all
+    bool instances;   // write meshes that are only moved copies once
+    double instanceTolerance; // compare instances within this, 0 for the float rounding
+    MaterialManifest materials;
+    std::vector<double> levels; // percentages of the facets of coarser versions
+    std::size_t chunkSize;      // split meshes into parts of at most this many facets, 0 for no split
+    std::size_t componentSize;  // split meshes into their connected parts, merging those with fewer facets, 0 for no split
+};
+
 std::string narrow(const std::wstring& str)
 {
     std::ostringstream stm;
@@ -85,6 +116,93 @@ bool endsWith(const String& value, const String& ending)
     return std::equal(ending.rbegin(), ending.rend(), value.rbegin());
 }
 
+// The used_entities_flag and sizes_triangulated of a face with the
+// triangles and strips of mesh. The indices of the triangles come first.
+uint32_t faceEntities(const Mesh& mesh, std::vector<uint32_t>& sizes)
+{
+    uint32_t flags = 0;
+    if (!mesh.facetArray.empty() || mesh.stripSizes.empty()) {
+        flags |= PRC_FACETESSDATA_Triangle;
+        sizes.push_back(static_cast<uint32_t>(mesh.facetArray.size()/3));
+    }
+    if (!mesh.stripSizes.empty()) {
+        flags |= PRC_FACETESSDATA_TriangleStripe;
+        sizes.push_back(static_cast<uint32_t>(mesh.stripSizes.size()));
+        sizes.insert(sizes.end(), mesh.stripSizes.begin(), mesh.stripSizes.end());
+    }
+    return flags;
+}
+
+// A plain triangle mesh that is written straight from the Mesh arrays
+// into the bit stream, meant to give the same bits as a PRC3DTess with
+// one face and no normals, without building the coordinate and index
+// vectors or the face object first. Only the serialization is
+// overridden, the data members of PRC3DTess stay empty. It is only used
+// with -direct until its output is compared with oPRCFile's.
+class MeshTess : public PRC3DTess
+{
+public:
+    // takes over the arrays of mesh
+    MeshTess(Mesh& mesh)
+    {
+        data.pointArray.swap(mesh.pointArray);
+        data.facetArray.swap(mesh.facetArray);
+        data.stripArray.swap(mesh.stripArray);
+        data.stripSizes.swap(mesh.stripSizes);
+    }
+
+    void serializeBaseTessData(PRCbitStream &pbs)
+    {
+        const std::vector<float>& pointArray = data.pointArray;
+        const std::vector<unsigned long>& facetArray = data.facetArray;
+        const std::vector<unsigned long>& stripArray = data.stripArray;
+        const uint32_t numberOfPoints = static_cast<uint32_t>(pointArray.size());
+        const uint32_t numberOfIndices = static_cast<uint32_t>(facetArray.size() + stripArray.size());
+
+        pbs << static_cast<uint32_t>(PRC_TYPE_TESS_3D);
+        pbs << false; // is_calculated
+        pbs << numberOfPoints;
+        for (std::size_t i = 0; i < pointArray.size(); ++i)
+            pbs << static_cast<double>(pointArray[i]);
+
+        pbs << true;  // has_faces
+        pbs << false; // has_loops
+        pbs << true;  // must_recalculate_normals
+        pbs << static_cast<uint8_t>(0); // normals_recalculation_flags
+        pbs << crease_angle;
+        pbs << static_cast<uint32_t>(0); // normal coordinates
+        pbs << static_cast<uint32_t>(0); // wire indices
+
+        // indices of x coordinates in the flat list
+        pbs << numberOfIndices;
+        for (std::size_t i = 0; i < facetArray.size(); ++i)
+            pbs << static_cast<uint32_t>(3 * facetArray[i]);
+        for (std::size_t i = 0; i < stripArray.size(); ++i)
+            pbs << static_cast<uint32_t>(3 * stripArray[i]);
+
+        // one face with all triangles and strips
+        std::vector<uint32_t> sizes;
+        const uint32_t flags = faceEntities(data, sizes);
+        pbs << static_cast<uint32_t>(1);
+        pbs << static_cast<uint32_t>(PRC_TYPE_TESS_Face);
+        pbs << static_cast<uint32_t>(0); // line attributes
+        pbs << static_cast<uint32_t>(0); // start_wire
+        pbs << static_cast<uint32_t>(0); // sizes_wire
+        pbs << flags;
+        pbs << static_cast<uint32_t>(0); // start_triangulated
+        pbs << static_cast<uint32_t>(sizes.size());
+        for (std::size_t i = 0; i < sizes.size(); ++i)
+            pbs << sizes[i];
+        pbs << static_cast<uint32_t>(0); // texture coordinate indexes
+        pbs << false; // has_vertex_colors
+
+        pbs << static_cast<uint32_t>(0); // texture coordinates
+    }
+
+private:
+    Mesh data;
+};
+
 void loadMesh(String inputName, Mesh& mesh)
 {
     std::ifstream istr(inputName.c_str(),
@@ -131,8 +249,9 @@ void loadMesh(String inputName, Mesh& mesh)
             pointArray.push_back(z);
         }
 
-        std::vector<unsigned long> facetArray;
+        std::vector<unsigned long> facetArray, neighbourArray;
         facetArray.reserve(3 * uCtFts);
+        neighbourArray.reserve(3 * uCtFts);
         for (uint32_t i = 0; i < uCtFts; ++i) {
             uint32_t v1, v2, v3;
             str >> v1 >> v2 >> v3;
@@ -142,6 +261,9 @@ void loadMesh(String inputName, Mesh& mesh)
 
             // The neighbour indices
             str >> v1 >> v2 >> v3;
+            neighbourArray.push_back(v1);
+            neighbourArray.push_back(v2);
+            neighbourArray.push_back(v3);
         }
 
         BoundingBox box;
@@ -152,59 +274,986 @@ void loadMesh(String inputName, Mesh& mesh)
         mesh.bbox = box;
         mesh.pointArray.swap(pointArray);
         mesh.facetArray.swap(facetArray);
+        mesh.neighbourArray.swap(neighbourArray);
     }
 }
 
-BoundingBox addMeshToPrc(String input, oPRCFile* prcFile, float alpha)
+// Rounds the coordinates of mesh to a grid, moving each by at most grid,
+// and/or to the given number of significant bits. PRC writes doubles
+// with trailing zero bytes in the mantissa much shorter, so the grid
+// spacing is a power of two. Returns the largest amount a coordinate
+// was moved by, which is what grid bounds.
+double quantizePoints(Mesh& mesh, double grid, int bits)
 {
-    Mesh mesh;
-    loadMesh(input, mesh);
+    double step = 0.0;
+    if (grid > 0.0)
+        step = std::ldexp(1.0, static_cast<int>(std::floor(std::log(2.0 * grid) / std::log(2.0))));
+
+    double deviation = 0.0;
+    for (std::size_t i = 0; i + 2 < mesh.pointArray.size(); i += 3) {
+        for (int k = 0; k < 3; ++k) {
+            double value = mesh.pointArray[i+k];
+            if (step > 0.0)
+                value = std::floor(value / step + 0.5) * step;
+            if (bits > 0 && value != 0.0) {
+                int exponent;
+                double mantissa = std::frexp(value, &exponent);
+                mantissa = std::floor(std::ldexp(mantissa, bits) + 0.5);
+                value = std::ldexp(mantissa, exponent - bits);
+            }
+            float quantized = static_cast<float>(value);
+            deviation = std::max<double>(deviation, std::fabs(static_cast<double>(quantized) - mesh.pointArray[i+k]));
+            mesh.pointArray[i+k] = quantized;
+        }
+    }
+    return deviation;
+}
 
-#if 1
-    const PRCmaterial materialMathGL(
-        RGBAColour(0.1,0.1,0.1,1), // ambient
-        RGBAColour(0.8,0.8,0.8,1), // diffuse
-        RGBAColour(0.1,0.1,0.1,1), // emissive
-        RGBAColour(0.0,0.0,0.0,1), // spectral
-        alpha,0.1 // alpha, shininess
-        );
-    uint32_t materialMathGLid = prcFile->addMaterial(materialMathGL);
+struct GridCell {
+    long long x, y, z;
+    bool operator<(const GridCell& c) const
+    {
+        if (x != c.x) return x < c.x;
+        if (y != c.y) return y < c.y;
+        return z < c.z;
+    }
+};
+
+// Merges the points that fall into the same cell of a grid with the given
+// spacing, keeping the first of them, and drops the triangles that become
+// degenerate. Mesh files store the corners of every facet separately in
+// many cases, so this takes out most of the points.
+void weldVertices(Mesh& mesh, double tolerance)
+{
+    if (tolerance <= 0.0)
+        return;
+
+    const std::size_t numberOfPoints = mesh.pointArray.size() / 3;
+    std::map<GridCell, unsigned long> cells;
+    std::vector<unsigned long> newIndex(numberOfPoints);
+    std::vector<float> pointArray;
+    pointArray.reserve(mesh.pointArray.size());
+    for (std::size_t i = 0; i < numberOfPoints; ++i) {
+        GridCell cell;
+        cell.x = static_cast<long long>(std::floor(mesh.pointArray[3*i+0] / tolerance + 0.5));
+        cell.y = static_cast<long long>(std::floor(mesh.pointArray[3*i+1] / tolerance + 0.5));
+        cell.z = static_cast<long long>(std::floor(mesh.pointArray[3*i+2] / tolerance + 0.5));
+        std::pair<std::map<GridCell, unsigned long>::iterator, bool> it =
+            cells.insert(std::make_pair(cell, static_cast<unsigned long>(pointArray.size() / 3)));
+        if (it.second) {
+            pointArray.push_back(mesh.pointArray[3*i+0]);
+            pointArray.push_back(mesh.pointArray[3*i+1]);
+            pointArray.push_back(mesh.pointArray[3*i+2]);
+        }
+        newIndex[i] = it.first->second;
+    }
+
+    const unsigned long open_edge = 0xffffffff;
+    const std::size_t numberOfFacets = mesh.facetArray.size() / 3;
+    std::vector<unsigned long> newFacet(numberOfFacets, open_edge);
+    std::vector<unsigned long> facetArray;
+    facetArray.reserve(mesh.facetArray.size());
+    for (std::size_t i = 0; i < numberOfFacets; ++i) {
+        unsigned long v1 = newIndex[mesh.facetArray[3*i+0]];
+        unsigned long v2 = newIndex[mesh.facetArray[3*i+1]];
+        unsigned long v3 = newIndex[mesh.facetArray[3*i+2]];
+        if (v1 == v2 || v2 == v3 || v3 == v1)
+            continue;
+        newFacet[i] = static_cast<unsigned long>(facetArray.size() / 3);
+        facetArray.push_back(v1);
+        facetArray.push_back(v2);
+        facetArray.push_back(v3);
+    }
+
+    // the neighbours across the edges of the remaining facets
+    std::vector<unsigned long> neighbourArray;
+    if (mesh.neighbourArray.size() == mesh.facetArray.size()) {
+        neighbourArray.reserve(facetArray.size());
+        for (std::size_t i = 0; i < numberOfFacets; ++i) {
+            if (newFacet[i] == open_edge)
+                continue;
+            for (int j = 0; j < 3; ++j) {
+                unsigned long n = mesh.neighbourArray[3*i+j];
+                neighbourArray.push_back(n < numberOfFacets ? newFacet[n] : open_edge);
+            }
+        }
+    }
+
+    mesh.pointArray.swap(pointArray);
+    mesh.facetArray.swap(facetArray);
+    mesh.neighbourArray.swap(neighbourArray);
+}
+
+// Spreads the lowest 21 bits of v to every third bit.
+uint64_t spreadBits(uint64_t v)
+{
+    v &= 0x1fffff;
+    v = (v | (v << 32)) & 0x1f00000000ffffULL;
+    v = (v | (v << 16)) & 0x1f0000ff0000ffULL;
+    v = (v | (v << 8))  & 0x100f00f00f00f00fULL;
+    v = (v | (v << 4))  & 0x10c30c30c30c30c3ULL;
+    v = (v | (v << 2))  & 0x1249249249249249ULL;
+    return v;
+}
+
+// Sorts the points of mesh along a Morton curve through their bounding
+// box, so that points close in space get close indices.
+void sortPoints(Mesh& mesh)
+{
+    const std::size_t numberOfPoints = mesh.pointArray.size() / 3;
+    if (numberOfPoints == 0)
+        return;
+
+    float minimum[3], maximum[3];
+    for (int k = 0; k < 3; ++k)
+        minimum[k] = maximum[k] = mesh.pointArray[k];
+    for (std::size_t i = 1; i < numberOfPoints; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            minimum[k] = std::min<float>(minimum[k], mesh.pointArray[3*i+k]);
+            maximum[k] = std::max<float>(maximum[k], mesh.pointArray[3*i+k]);
+        }
+    }
+
+    std::vector<std::pair<uint64_t, unsigned long> > keys(numberOfPoints);
+    for (std::size_t i = 0; i < numberOfPoints; ++i) {
+        uint64_t code = 0;
+        for (int k = 0; k < 3; ++k) {
+            double extent = maximum[k] - minimum[k];
+            uint64_t cell = extent > 0.0
+                ? static_cast<uint64_t>((mesh.pointArray[3*i+k] - minimum[k]) / extent * 0x1fffff)
+                : 0;
+            code |= spreadBits(cell) << k;
+        }
+        keys[i] = std::make_pair(code, static_cast<unsigned long>(i));
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<unsigned long> newIndex(numberOfPoints);
+    std::vector<float> pointArray(mesh.pointArray.size());
+    for (std::size_t i = 0; i < numberOfPoints; ++i) {
+        unsigned long old = keys[i].second;
+        newIndex[old] = static_cast<unsigned long>(i);
+        pointArray[3*i+0] = mesh.pointArray[3*old+0];
+        pointArray[3*i+1] = mesh.pointArray[3*old+1];
+        pointArray[3*i+2] = mesh.pointArray[3*old+2];
+    }
+    for (std::size_t i = 0; i < mesh.facetArray.size(); ++i)
+        mesh.facetArray[i] = newIndex[mesh.facetArray[i]];
+    mesh.pointArray.swap(pointArray);
+}
+
+const int vertexCacheSize = 32;
+
+// The score of a point in the vertex cache optimization of Tom Forsyth:
+// points recently used and points with few facets left score high.
+float vertexScore(int cachePosition, unsigned long remaining)
+{
+    if (remaining == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        // the points of the last facet get a fixed score, so that the
+        // next facet does not simply reuse the same edge
+        if (cachePosition < 3)
+            score = 0.75f;
+        else
+            score = std::pow(1.0f - float(cachePosition - 3) / (vertexCacheSize - 3), 1.5f);
+    }
+    return score + 2.0f / std::sqrt(float(remaining));
+}
+
+// Orders the facets of mesh so that consecutive facets share points as
+// much as possible, after Forsyth's "Linear-Speed Vertex Cache
+// Optimisation". Each step takes the facet with the best score among
+// those of the points in a simulated cache.
+void sortFacets(Mesh& mesh)
+{
+    const std::size_t numberOfPoints = mesh.pointArray.size() / 3;
+    const std::size_t numberOfFacets = mesh.facetArray.size() / 3;
+    if (numberOfFacets == 0)
+        return;
+
+    // the facets of each point; the first remaining[p] of them are not
+    // placed yet
+    std::vector<unsigned long> first(numberOfPoints + 1, 0);
+    for (std::size_t i = 0; i < mesh.facetArray.size(); ++i)
+        ++first[mesh.facetArray[i] + 1];
+    for (std::size_t p = 0; p < numberOfPoints; ++p)
+        first[p+1] += first[p];
+    std::vector<unsigned long> facetsOfPoint(mesh.facetArray.size());
+    std::vector<unsigned long> remaining(numberOfPoints, 0);
+    for (std::size_t i = 0; i < mesh.facetArray.size(); ++i) {
+        unsigned long p = mesh.facetArray[i];
+        facetsOfPoint[first[p] + remaining[p]++] = static_cast<unsigned long>(i / 3);
+    }
+
+    std::vector<int> cachePosition(numberOfPoints, -1);
+    std::vector<float> score(numberOfPoints);
+    for (std::size_t p = 0; p < numberOfPoints; ++p)
+        score[p] = vertexScore(-1, remaining[p]);
+    std::vector<float> facetScore(numberOfFacets);
+    std::vector<bool> placed(numberOfFacets, false);
+    for (std::size_t f = 0; f < numberOfFacets; ++f) {
+        facetScore[f] = score[mesh.facetArray[3*f]] +
+                        score[mesh.facetArray[3*f+1]] +
+                        score[mesh.facetArray[3*f+2]];
+    }
+
+    std::vector<unsigned long> order;
+    order.reserve(numberOfFacets);
+    std::vector<unsigned long> cache, newCache;
+    std::size_t nextUnplaced = 0;
+    std::size_t best = numberOfFacets;
+    while (order.size() < numberOfFacets) {
+        if (best == numberOfFacets) {
+            // nothing in the cache, take the next facet in index order
+            while (placed[nextUnplaced])
+                ++nextUnplaced;
+            best = nextUnplaced;
+        }
+
+        placed[best] = true;
+        order.push_back(static_cast<unsigned long>(best));
+        newCache.clear();
+        for (int j = 0; j < 3; ++j) {
+            unsigned long p = mesh.facetArray[3*best+j];
+            // take the facet off the remaining ones of the point
+            unsigned long* facets = &facetsOfPoint[first[p]];
+            for (unsigned long k = 0; k < remaining[p]; ++k) {
+                if (facets[k] == best) {
+                    std::swap(facets[k], facets[remaining[p]-1]);
+                    --remaining[p];
+                    break;
+                }
+            }
+            if (std::find(newCache.begin(), newCache.end(), p) == newCache.end())
+                newCache.push_back(p);
+        }
+        const std::size_t used = newCache.size();
+        for (std::size_t i = 0; i < cache.size(); ++i) {
+            if (std::find(newCache.begin(), newCache.begin() + used, cache[i]) == newCache.begin() + used)
+                newCache.push_back(cache[i]);
+        }
+
+        // update the scores of the points in the cache and of those
+        // falling out of it, and pick the best facet of them
+        float bestScore = -1.0f;
+        best = numberOfFacets;
+        for (std::size_t i = 0; i < newCache.size(); ++i) {
+            unsigned long p = newCache[i];
+            cachePosition[p] = i < std::size_t(vertexCacheSize) ? int(i) : -1;
+            float delta = vertexScore(cachePosition[p], remaining[p]) - score[p];
+            score[p] += delta;
+            for (unsigned long k = 0; k < remaining[p]; ++k) {
+                unsigned long f = facetsOfPoint[first[p] + k];
+                facetScore[f] += delta;
+                if (facetScore[f] > bestScore) {
+                    bestScore = facetScore[f];
+                    best = f;
+                }
+            }
+        }
+        if (newCache.size() > std::size_t(vertexCacheSize))
+            newCache.resize(vertexCacheSize);
+        cache.swap(newCache);
+    }
+
+    // put the facets and their neighbours into the new order
+    std::vector<unsigned long> newFacet(numberOfFacets);
+    for (std::size_t i = 0; i < numberOfFacets; ++i)
+        newFacet[order[i]] = static_cast<unsigned long>(i);
+    std::vector<unsigned long> facetArray(mesh.facetArray.size());
+    for (std::size_t i = 0; i < numberOfFacets; ++i) {
+        for (int j = 0; j < 3; ++j)
+            facetArray[3*i+j] = mesh.facetArray[3*order[i]+j];
+    }
+    mesh.facetArray.swap(facetArray);
+    if (mesh.neighbourArray.size() == 3 * numberOfFacets) {
+        std::vector<unsigned long> neighbourArray(mesh.neighbourArray.size());
+        for (std::size_t i = 0; i < numberOfFacets; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                unsigned long n = mesh.neighbourArray[3*order[i]+j];
+                neighbourArray[3*i+j] = n < numberOfFacets ? newFacet[n] : n;
+            }
+        }
+        mesh.neighbourArray.swap(neighbourArray);
+    }
+}
+
+// is v the triangle a, b, c with the same orientation?
+bool isTriangle(const unsigned long* v, unsigned long a, unsigned long b, unsigned long c)
+{
+    return (v[0] == a && v[1] == b && v[2] == c) ||
+           (v[1] == a && v[2] == b && v[0] == c) ||
+           (v[2] == a && v[0] == b && v[1] == c);
+}
+
+// Starts a strip with facet start, beginning at its point rotation, and
+// continues it over the neighbours as long as the next facet shares the
+// last edge of the strip and has the orientation the strip gives it.
+// The facets taken are set to stamp in visited, facets with stamp or
+// used are not taken.
+void walkStrip(const Mesh& mesh, unsigned long start, int rotation,
+               std::vector<unsigned long>& visited, unsigned long stamp, unsigned long used,
+               std::vector<unsigned long>& strip, std::vector<unsigned long>& facets)
+{
+    const std::size_t numberOfFacets = mesh.facetArray.size() / 3;
+    const unsigned long* v = &mesh.facetArray[3*start];
+    strip.push_back(v[rotation]);
+    strip.push_back(v[(rotation+1)%3]);
+    strip.push_back(v[(rotation+2)%3]);
+    facets.push_back(start);
+    visited[start] = stamp;
+
+    unsigned long current = start;
+    for (;;) {
+        const std::size_t n = strip.size();
+        const unsigned long a = strip[n-2];
+        const unsigned long b = strip[n-1];
+        v = &mesh.facetArray[3*current];
+
+        unsigned long next = numberOfFacets;
+        for (int j = 0; j < 3; ++j) {
+            unsigned long p = v[j], q = v[(j+1)%3];
+            if ((p == a && q == b) || (p == b && q == a)) {
+                next = mesh.neighbourArray[3*current+j];
+                break;
+            }
+        }
+        if (next >= numberOfFacets || visited[next] == stamp || visited[next] == used)
+            break;
+
+        const unsigned long* w = &mesh.facetArray[3*next];
+        unsigned long c = w[0];
+        if (c == a || c == b)
+            c = w[1];
+        if (c == a || c == b)
+            c = w[2];
+        // the triangles of a strip alternate in orientation
+        bool odd = (n % 2) != 0;
+        if (!(odd ? isTriangle(w, b, a, c) : isTriangle(w, a, b, c)))
+            break;
+
+        strip.push_back(c);
+        facets.push_back(next);
+        visited[next] = stamp;
+        current = next;
+    }
+}
+
+// Joins the facets of mesh to triangle strips, going greedily from one
+// facet to its neighbour. Each strip starts at the first facet not yet
+// used, with the edge that gives the longest strip. Facets that end up
+// alone stay in the facet list.
+void buildStrips(Mesh& mesh)
+{
+    const std::size_t numberOfFacets = mesh.facetArray.size() / 3;
+    if (mesh.neighbourArray.size() != mesh.facetArray.size())
+        return;
+
+    const unsigned long used = 1;
+    unsigned long stamp = used;
+    std::vector<unsigned long> visited(numberOfFacets, 0);
+    std::vector<unsigned long> facetArray;
+    std::vector<unsigned long> strip, facets, bestStrip, bestFacets;
+    for (std::size_t f = 0; f < numberOfFacets; ++f) {
+        if (visited[f] == used)
+            continue;
+
+        bestStrip.clear();
+        bestFacets.clear();
+        for (int rotation = 0; rotation < 3; ++rotation) {
+            strip.clear();
+            facets.clear();
+            walkStrip(mesh, static_cast<unsigned long>(f), rotation, visited, ++stamp, used, strip, facets);
+            if (strip.size() > bestStrip.size()) {
+                bestStrip.swap(strip);
+                bestFacets.swap(facets);
+            }
+        }
+
+        for (std::size_t i = 0; i < bestFacets.size(); ++i)
+            visited[bestFacets[i]] = used;
+        if (bestFacets.size() > 1) {
+            mesh.stripArray.insert(mesh.stripArray.end(), bestStrip.begin(), bestStrip.end());
+            mesh.stripSizes.push_back(static_cast<uint32_t>(bestStrip.size()));
+        }
+        else {
+            facetArray.insert(facetArray.end(), mesh.facetArray.begin() + 3*f, mesh.facetArray.begin() + 3*f + 3);
+        }
+    }
+
+    mesh.facetArray.swap(facetArray);
+    mesh.neighbourArray.clear();
+}
+
+// Makes result a coarser version of mesh with at most the given fraction
+// of its facets, by merging the points in the cells of a grid. The
+// spacing is searched for by bisection, from the size of the mesh down.
+void simplifyMesh(const Mesh& mesh, double fraction, Mesh& result)
+{
+    const std::size_t target = static_cast<std::size_t>(fraction * (mesh.facetArray.size() / 3));
+    double extent = 0.0;
+    extent = std::max<double>(extent, mesh.bbox.maxX - mesh.bbox.minX);
+    extent = std::max<double>(extent, mesh.bbox.maxY - mesh.bbox.minY);
+    extent = std::max<double>(extent, mesh.bbox.maxZ - mesh.bbox.minZ);
+
+    double fine = 0.0, coarse = extent;
+    result = mesh;
+    weldVertices(result, coarse);
+    for (int i = 0; i < 20 && result.facetArray.size() / 3 != target; ++i) {
+        double spacing = 0.5 * (fine + coarse);
+        Mesh candidate(mesh);
+        weldVertices(candidate, spacing);
+        if (candidate.facetArray.size() / 3 > target) {
+            fine = spacing;
+        }
+        else {
+            coarse = spacing;
+            result.pointArray.swap(candidate.pointArray);
+            result.facetArray.swap(candidate.facetArray);
+            result.neighbourArray.swap(candidate.neighbourArray);
+        }
+    }
+}
+
+// Puts the facets from first to last in an order where the i-th group
+// of sizes[i] facets, in sizes added in that order, is a box of space
+// with at most maxFacets facets. The box of a group is split at the
+// median of the facet centres along its longest side; the first halves
+// of the upper splits go to threads of their own.
+void splitFacets(const std::vector<float>& centres, unsigned long* first, unsigned long* last,
+                 std::size_t maxFacets, int depth, std::vector<std::size_t>& sizes)
+{
+    const std::size_t count = last - first;
+    if (count <= maxFacets) {
+        if (count > 0)
+            sizes.push_back(count);
+        return;
+    }
+
+    float minimum[3], maximum[3];
+    for (int k = 0; k < 3; ++k) {
+        minimum[k] = maximum[k] = centres[3*first[0]+k];
+    }
+    for (const unsigned long* f = first; f != last; ++f) {
+        for (int k = 0; k < 3; ++k) {
+            minimum[k] = std::min<float>(minimum[k], centres[3*(*f)+k]);
+            maximum[k] = std::max<float>(maximum[k], centres[3*(*f)+k]);
+        }
+    }
+    int axis = 0;
+    for (int k = 1; k < 3; ++k) {
+        if (maximum[k] - minimum[k] > maximum[axis] - minimum[axis])
+            axis = k;
+    }
+
+    unsigned long* middle = first + count / 2;
+    std::nth_element(first, middle, last, [&centres, axis](unsigned long a, unsigned long b) {
+        return centres[3*a+axis] < centres[3*b+axis];
+    });
+
+    if (depth < 3) {
+        std::vector<std::size_t> lower;
+        std::thread thread(splitFacets, std::cref(centres), first, middle, maxFacets, depth + 1, std::ref(lower));
+        std::vector<std::size_t> upper;
+        splitFacets(centres, middle, last, maxFacets, depth + 1, upper);
+        thread.join();
+        sizes.insert(sizes.end(), lower.begin(), lower.end());
+        sizes.insert(sizes.end(), upper.begin(), upper.end());
+    }
+    else {
+        splitFacets(centres, first, middle, maxFacets, depth + 1, sizes);
+        splitFacets(centres, middle, last, maxFacets, depth + 1, sizes);
+    }
+}
 
-    PRC3DTess *tess = new PRC3DTess();
-    tess->crease_angle = 0.0;
+// Makes chunk a mesh of the given facets of mesh, with only the points
+// they use, their neighbours among them and its own bounding box.
+void extractChunk(const Mesh& mesh, const unsigned long* facets, std::size_t count, Mesh& chunk)
+{
+    const unsigned long open_edge = 0xffffffff;
+    std::unordered_map<unsigned long, unsigned long> newIndex, newFacet;
+    for (std::size_t i = 0; i < count; ++i)
+        newFacet[facets[i]] = static_cast<unsigned long>(i);
+
+    const bool hasNeighbours = mesh.neighbourArray.size() == mesh.facetArray.size();
+    for (std::size_t i = 0; i < count; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            unsigned long p = mesh.facetArray[3*facets[i]+j];
+            std::pair<std::unordered_map<unsigned long, unsigned long>::iterator, bool> it =
+                newIndex.insert(std::make_pair(p, static_cast<unsigned long>(chunk.pointArray.size() / 3)));
+            if (it.second) {
+                chunk.pointArray.push_back(mesh.pointArray[3*p+0]);
+                chunk.pointArray.push_back(mesh.pointArray[3*p+1]);
+                chunk.pointArray.push_back(mesh.pointArray[3*p+2]);
+            }
+            chunk.facetArray.push_back(it.first->second);
+            if (hasNeighbours) {
+                std::unordered_map<unsigned long, unsigned long>::const_iterator n =
+                    newFacet.find(mesh.neighbourArray[3*facets[i]+j]);
+                chunk.neighbourArray.push_back(n != newFacet.end() ? n->second : open_edge);
+            }
+        }
+    }
 
-    // Copy point coordinates
-    tess->coordinates.insert(tess->coordinates.begin(), mesh.pointArray.begin(), mesh.pointArray.end());
+    BoundingBox& box = chunk.bbox;
+    box.minX = box.maxX = chunk.pointArray[0];
+    box.minY = box.maxY = chunk.pointArray[1];
+    box.minZ = box.maxZ = chunk.pointArray[2];
+    for (std::size_t i = 3; i + 2 < chunk.pointArray.size(); i += 3) {
+        box.minX = std::min<float>(box.minX, chunk.pointArray[i+0]);
+        box.maxX = std::max<float>(box.maxX, chunk.pointArray[i+0]);
+        box.minY = std::min<float>(box.minY, chunk.pointArray[i+1]);
+        box.maxY = std::max<float>(box.maxY, chunk.pointArray[i+1]);
+        box.minZ = std::min<float>(box.minZ, chunk.pointArray[i+2]);
+        box.maxZ = std::max<float>(box.maxZ, chunk.pointArray[i+2]);
+    }
+}
 
-    PRCTessFace *tessFace = new PRCTessFace();
-    tessFace->number_of_texture_coordinate_indexes = 0;
-    tessFace->start_triangulated = 0;
-    tessFace->used_entities_flag = PRC_FACETESSDATA_Triangle;
-    tessFace->is_rgba = false;
+// Splits mesh into chunks of at most maxFacets facets that are close
+// together in space.
+void splitMesh(const Mesh& mesh, std::size_t maxFacets, std::vector<Mesh>& chunks)
+{
+    const std::size_t numberOfFacets = mesh.facetArray.size() / 3;
+    std::vector<float> centres(3 * numberOfFacets);
+    std::vector<unsigned long> order(numberOfFacets);
+    for (std::size_t f = 0; f < numberOfFacets; ++f) {
+        for (int k = 0; k < 3; ++k) {
+            centres[3*f+k] = (mesh.pointArray[3*mesh.facetArray[3*f+0]+k] +
+                              mesh.pointArray[3*mesh.facetArray[3*f+1]+k] +
+                              mesh.pointArray[3*mesh.facetArray[3*f+2]+k]) / 3.0f;
+        }
+        order[f] = static_cast<unsigned long>(f);
+    }
 
-    tess->has_faces = true;
+    std::vector<std::size_t> sizes;
+    splitFacets(centres, &order[0], &order[0] + numberOfFacets, maxFacets, 0, sizes);
 
-    // Copy and adjust face indices to correctly reference in a flat list
-    tess->triangulated_index.reserve(mesh.facetArray.size());
-    for (std::size_t index = 0; index < mesh.facetArray.size(); ++index) {
-        tess->triangulated_index.push_back(3 * mesh.facetArray[index]);
+    chunks.resize(sizes.size());
+    std::size_t first = 0;
+    for (std::size_t i = 0; i < sizes.size(); ++i) {
+        extractChunk(mesh, &order[first], sizes[i], chunks[i]);
+        first += sizes[i];
     }
+}
 
-    tessFace->sizes_triangulated.push_back(static_cast<uint32_t>(mesh.facetArray.size()/3));
-    tess->addTessFace(tessFace);
+// the representative of the set of point p, with path halving
+unsigned long findSet(std::vector<unsigned long>& parent, unsigned long p)
+{
+    while (parent[p] != p) {
+        parent[p] = parent[parent[p]];
+        p = parent[p];
+    }
+    return p;
+}
 
-    uint32_t tess_index = prcFile->add3DTess(tess);
-    prcFile->useMesh(tess_index, materialMathGLid);
+// Splits mesh into its parts that are connected over shared points.
+// Parts with fewer than minFacets facets are gathered, in the order of
+// their first facet, into parts of at least minFacets facets; what is
+// left at the end joins the last part, unless the whole mesh is smaller.
+void splitComponents(const Mesh& mesh, std::size_t minFacets, std::vector<Mesh>& parts)
+{
+    const std::size_t numberOfPoints = mesh.pointArray.size() / 3;
+    const std::size_t numberOfFacets = mesh.facetArray.size() / 3;
+    std::vector<unsigned long> parent(numberOfPoints);
+    for (std::size_t p = 0; p < numberOfPoints; ++p)
+        parent[p] = static_cast<unsigned long>(p);
+    for (std::size_t f = 0; f < numberOfFacets; ++f) {
+        unsigned long a = findSet(parent, mesh.facetArray[3*f]);
+        for (int j = 1; j < 3; ++j) {
+            unsigned long b = findSet(parent, mesh.facetArray[3*f+j]);
+            if (a != b) {
+                // the lower index stays the representative
+                if (b < a)
+                    std::swap(a, b);
+                parent[b] = a;
+            }
+        }
+    }
 
-    // set name
+    // the facets of each component, numbered by first facet
+    std::unordered_map<unsigned long, std::size_t> componentOfSet;
+    std::vector<std::vector<unsigned long> > components;
+    for (std::size_t f = 0; f < numberOfFacets; ++f) {
+        unsigned long set = findSet(parent, mesh.facetArray[3*f]);
+        std::pair<std::unordered_map<unsigned long, std::size_t>::iterator, bool> it =
+            componentOfSet.insert(std::make_pair(set, components.size()));
+        if (it.second)
+            components.push_back(std::vector<unsigned long>());
+        components[it.first->second].push_back(static_cast<unsigned long>(f));
+    }
+
+    std::vector<std::vector<unsigned long> > groups;
+    std::vector<unsigned long> small;
+    for (std::size_t c = 0; c < components.size(); ++c) {
+        if (components[c].size() >= minFacets) {
+            groups.push_back(std::vector<unsigned long>());
+            groups.back().swap(components[c]);
+            continue;
+        }
+        small.insert(small.end(), components[c].begin(), components[c].end());
+        if (small.size() >= minFacets) {
+            groups.push_back(std::vector<unsigned long>());
+            groups.back().swap(small);
+        }
+    }
+    if (!small.empty()) {
+        if (groups.empty())
+            groups.push_back(small);
+        else
+            groups.back().insert(groups.back().end(), small.begin(), small.end());
+    }
+
+    parts.resize(groups.size());
+    for (std::size_t i = 0; i < groups.size(); ++i)
+        extractChunk(mesh, &groups[i][0], groups[i].size(), parts[i]);
+}
+
+// A mesh as it was loaded, moved to its lowest corner, and the
+// tessellation written for it. Later meshes with the same facets and
+// points, up to a translation, use the tessellation again.
+struct MeshInstance {
+    std::vector<float> pointArray;
+    std::vector<unsigned long> facetArray;
+    float origin[3];
+    std::vector<uint32_t> tess_indices; // full detail first, then the levels
+};
+
+typedef std::multimap<uint64_t, MeshInstance> InstanceMap;
+
+// The lowest corner of the points of mesh.
+void meshOrigin(const Mesh& mesh, float origin[3])
+{
+    for (int k = 0; k < 3; ++k)
+        origin[k] = mesh.pointArray.size() < 3 ? 0.0f : mesh.pointArray[k];
+    for (std::size_t i = 0; i + 2 < mesh.pointArray.size(); i += 3) {
+        for (int k = 0; k < 3; ++k)
+            origin[k] = std::min<float>(origin[k], mesh.pointArray[i+k]);
+    }
+}
+
+// 64 bit FNV-1a, by word, of the number of points and the facets of
+// mesh. The points are left out, as copies moved by an amount that is
+// not exact in float do not round to the same values; isInstance()
+// compares them within a tolerance.
+uint64_t meshHash(const Mesh& mesh)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    hash ^= mesh.pointArray.size();
+    hash *= 1099511628211ULL;
+    for (std::size_t i = 0; i < mesh.facetArray.size(); ++i) {
+        hash ^= mesh.facetArray[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// does mesh, moved to origin, match instance within tolerance?
+bool isInstance(const MeshInstance& instance, const Mesh& mesh, const float origin[3], double tolerance)
+{
+    if (instance.facetArray != mesh.facetArray || instance.pointArray.size() != mesh.pointArray.size())
+        return false;
+    for (std::size_t i = 0; i < mesh.pointArray.size(); ++i) {
+        if (std::fabs((mesh.pointArray[i] - origin[i%3]) - instance.pointArray[i]) > tolerance)
+            return false;
+    }
+    return true;
+}
+
+// What is shared between the meshes written into one PRC file.
+struct OutputState {
+    InstanceMap instances;
+    std::map<std::vector<double>, uint32_t> materials; // by their values
+};
+
+// Adds material to the file unless a material with the same values was
+// added already, and returns the index of its style.
+uint32_t internMaterial(oPRCFile* prcFile, OutputState& state, const PRCmaterial& material)
+{
+    const RGBAColour* colours[4] = {
+        &material.ambient, &material.diffuse, &material.emissive, &material.specular
+    };
+    std::vector<double> key;
+    for (int i = 0; i < 4; ++i) {
+        key.push_back(colours[i]->R);
+        key.push_back(colours[i]->G);
+        key.push_back(colours[i]->B);
+        key.push_back(colours[i]->A);
+    }
+    key.push_back(material.alpha);
+    key.push_back(material.shininess);
+
+    std::map<std::vector<double>, uint32_t>::iterator it = state.materials.find(key);
+    if (it != state.materials.end())
+        return it->second;
+    uint32_t index = prcFile->addMaterial(material);
+    state.materials.insert(std::make_pair(key, index));
+    return index;
+}
+
+// Reads lines of <file> <red> <green> <blue> [<alpha>], with colours
+// from 0 to 1. Empty lines and lines starting with # are skipped.
+bool readManifest(const String& fileName, MaterialManifest& manifest)
+{
+    std::ifstream istr(fileName.c_str());
+    if (!istr) {
+        printf ("Unable to open material manifest.\n");
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(istr, line)) {
+        ++lineNumber;
+        std::istringstream fields(line);
+        std::string name;
+        if (!(fields >> name) || name[0] == '#')
+            continue;
+
+        MaterialOverride material;
+        if (!(fields >> material.red >> material.green >> material.blue)) {
+            printf ("Invalid line %d in material manifest: %s\n", lineNumber, line.c_str());
+            return false;
+        }
+        if (!(fields >> material.alpha))
+            material.alpha = -1.0;
+        manifest[name] = material;
+    }
+    return true;
+}
+
+// Names the last mesh added after its input file, with suffix added, and
+// hides it unless visible.
+void setMeshName(oPRCFile* prcFile, const String& input, const std::string& suffix, bool visible)
+{
     std::size_t found = input.find_last_of(PATHSEP);
     String name = input.substr(found+1);
     PRCgroup &group = prcFile->findGroup();
 #ifdef USE_WIDE_CHAR
-    group.polymodels.back()->name = narrow(name);
+    group.polymodels.back()->name = narrow(name) + suffix;
 #else
-    group.polymodels.back()->name = name;
+    group.polymodels.back()->name = name + suffix;
 #endif
+    if (!visible)
+        group.polymodels.back()->behaviour_bit_field &= ~PRC_GRAPHICS_Show;
+}
+
+// the name suffix of a level of detail
+std::string levelName(double percentage)
+{
+    std::ostringstream name;
+    name << " (" << percentage << "%)";
+    return name.str();
+}
+
+// Writes mesh as a new tessellation and returns its index. The arrays
+// of mesh may be taken over.
+uint32_t addTessellation(oPRCFile* prcFile, Mesh& mesh, const Options& options)
+{
+    if (options.reorder) {
+        sortPoints(mesh);
+        sortFacets(mesh);
+    }
+    if (options.strips)
+        buildStrips(mesh);
+
+    PRC3DTess *tess;
+    if (options.direct) {
+        tess = new MeshTess(mesh);
+        tess->crease_angle = 0.0;
+        tess->has_faces = true;
+    }
+    else {
+        tess = new PRC3DTess();
+        tess->crease_angle = 0.0;
+
+        // Copy point coordinates
+        tess->coordinates.insert(tess->coordinates.begin(), mesh.pointArray.begin(), mesh.pointArray.end());
+
+        PRCTessFace *tessFace = new PRCTessFace();
+        tessFace->number_of_texture_coordinate_indexes = 0;
+        tessFace->start_triangulated = 0;
+        tessFace->used_entities_flag = faceEntities(mesh, tessFace->sizes_triangulated);
+        tessFace->is_rgba = false;
+
+        tess->has_faces = true;
+
+        // Copy and adjust face indices to correctly reference in a flat list
+        tess->triangulated_index.reserve(mesh.facetArray.size() + mesh.stripArray.size());
+        for (std::size_t index = 0; index < mesh.facetArray.size(); ++index) {
+            tess->triangulated_index.push_back(3 * mesh.facetArray[index]);
+        }
+        for (std::size_t index = 0; index < mesh.stripArray.size(); ++index) {
+            tess->triangulated_index.push_back(3 * mesh.stripArray[index]);
+        }
+
+        tess->addTessFace(tessFace);
+    }
+
+    return prcFile->add3DTess(tess);
+}
+
+// Writes mesh and its coarser levels, and adds them to the current
+// product occurrence. Only the coarsest of them is shown at first.
+void writeMesh(oPRCFile* prcFile, Mesh& mesh, const String& input, uint32_t material,
+               const Options& options, std::vector<uint32_t>& tess_indices)
+{
+    // the coarser versions, each on a thread of its own
+    std::vector<Mesh> levels(options.levels.size());
+    std::vector<std::thread> simplifiers;
+    for (std::size_t level = 0; level < levels.size(); ++level) {
+        simplifiers.push_back(std::thread(simplifyMesh, std::cref(mesh),
+                                          options.levels[level] / 100.0, std::ref(levels[level])));
+    }
+    for (std::size_t level = 0; level < simplifiers.size(); ++level)
+        simplifiers[level].join();
+
+    uint32_t tess_index = addTessellation(prcFile, mesh, options);
+    prcFile->useMesh(tess_index, material);
+    setMeshName(prcFile, input, std::string(), levels.empty());
+    tess_indices.push_back(tess_index);
+    for (std::size_t level = 0; level < levels.size(); ++level) {
+        tess_index = addTessellation(prcFile, levels[level], options);
+        prcFile->useMesh(tess_index, material);
+        setMeshName(prcFile, input, levelName(options.levels[level]), level + 1 == levels.size());
+        tess_indices.push_back(tess_index);
+    }
+}
+
+// Writes mesh like writeMesh(), or, if it has more facets than -chunk
+// allows, split into chunks in product occurrences of their own, so that
+// viewers can skip the ones out of sight. Returns whether it was split.
+bool writeChunks(oPRCFile* prcFile, Mesh& mesh, const String& input, const std::string& name,
+                 uint32_t material, const Options& options, std::vector<uint32_t>& tess_indices)
+{
+    if (options.chunkSize == 0 || mesh.facetArray.size() / 3 <= options.chunkSize) {
+        writeMesh(prcFile, mesh, input, material, options, tess_indices);
+        return false;
+    }
+
+    std::vector<Mesh> chunks;
+    splitMesh(mesh, options.chunkSize, chunks);
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        std::ostringstream chunkName;
+        chunkName << name << " #" << i + 1;
+        prcFile->begingroup(chunkName.str().c_str());
+        std::vector<uint32_t> chunk_indices;
+        writeMesh(prcFile, chunks[i], input, material, options, chunk_indices);
+        prcFile->endgroup();
+    }
+    return true;
+}
+
+BoundingBox addMeshToPrc(String input, oPRCFile* prcFile, float alpha, const Options& options,
+                         OutputState& state)
+{
+    Mesh mesh;
+    loadMesh(input, mesh);
+
+    // the manifest may give another colour, by path or by file name
+#ifdef USE_WIDE_CHAR
+    std::string path = narrow(input);
+#else
+    std::string path = input;
+#endif
+    MaterialManifest::const_iterator found = options.materials.find(path);
+    if (found == options.materials.end())
+        found = options.materials.find(path.substr(path.find_last_of("/\\") + 1));
+    RGBAColour diffuse(0.8,0.8,0.8,1);
+    if (found != options.materials.end()) {
+        diffuse = RGBAColour(found->second.red, found->second.green, found->second.blue, 1);
+        if (found->second.alpha >= 0.0)
+            alpha = static_cast<float>(found->second.alpha);
+    }
+
+    const PRCmaterial materialMathGL(
+        RGBAColour(0.1,0.1,0.1,1), // ambient
+        diffuse,                   // diffuse
+        RGBAColour(0.1,0.1,0.1,1), // emissive
+        RGBAColour(0.0,0.0,0.0,1), // spectral
+        alpha,0.1 // alpha, shininess
+        );
+    uint32_t materialMathGLid = internMaterial(prcFile, state, materialMathGL);
+
+    // a copy of an earlier mesh only gets a new reference to its
+    // tessellation, moved to where this one is
+    MeshInstance instance;
+    uint64_t hash = 0;
+    if (options.instances) {
+        // without a tolerance, allow for the rounding of the float
+        // coordinates, which grows with their distance from zero
+        double tolerance = options.instanceTolerance;
+        if (tolerance <= 0.0) {
+            float magnitude = 1.0f;
+            magnitude = std::max<float>(magnitude, std::max<float>(std::fabs(mesh.bbox.minX), std::fabs(mesh.bbox.maxX)));
+            magnitude = std::max<float>(magnitude, std::max<float>(std::fabs(mesh.bbox.minY), std::fabs(mesh.bbox.maxY)));
+            magnitude = std::max<float>(magnitude, std::max<float>(std::fabs(mesh.bbox.minZ), std::fabs(mesh.bbox.maxZ)));
+            tolerance = 1e-5 * magnitude;
+        }
+        meshOrigin(mesh, instance.origin);
+        hash = meshHash(mesh);
+        std::pair<InstanceMap::iterator, InstanceMap::iterator> range = state.instances.equal_range(hash);
+        for (InstanceMap::iterator it = range.first; it != range.second; ++it) {
+            if (isInstance(it->second, mesh, instance.origin, tolerance)) {
+                const double origin[3] = {
+                    double(instance.origin[0]) - it->second.origin[0],
+                    double(instance.origin[1]) - it->second.origin[1],
+                    double(instance.origin[2]) - it->second.origin[2]
+                };
+                const double x_axis[3] = { 1.0, 0.0, 0.0 };
+                const double y_axis[3] = { 0.0, 1.0, 0.0 };
+                const std::vector<uint32_t>& tess_indices = it->second.tess_indices;
+                for (std::size_t level = 0; level < tess_indices.size(); ++level) {
+                    prcFile->useMesh(tess_indices[level], materialMathGLid, origin, x_axis, y_axis, 1.0);
+                    setMeshName(prcFile, input, level == 0 ? std::string() : levelName(options.levels[level-1]),
+                                level + 1 == tess_indices.size());
+                }
+                return mesh.bbox;
+            }
+        }
+        instance.facetArray = mesh.facetArray;
+        instance.pointArray.resize(mesh.pointArray.size());
+        for (std::size_t i = 0; i < mesh.pointArray.size(); ++i)
+            instance.pointArray[i] = mesh.pointArray[i] - instance.origin[i%3];
+    }
+
+    if (options.grid > 0.0 || options.bits > 0) {
+        double deviation = quantizePoints(mesh, options.grid, options.bits);
+        printf ("Maximum deviation of quantized coordinates: %g\n", deviation);
+    }
+    weldVertices(mesh, options.weldTolerance);
+    BoundingBox bbox = mesh.bbox;
+
+#if 1
+    std::size_t separator = input.find_last_of(PATHSEP);
+#ifdef USE_WIDE_CHAR
+    std::string name = narrow(input.substr(separator+1));
+#else
+    std::string name = input.substr(separator+1);
+#endif
+
+    // a product occurrence for each connected part, so that they can be
+    // shown and selected one by one; split meshes are not used as
+    // instances
+    std::vector<Mesh> components;
+    if (options.componentSize > 0)
+        splitComponents(mesh, options.componentSize, components);
+    if (components.size() > 1) {
+        for (std::size_t i = 0; i < components.size(); ++i) {
+            std::ostringstream componentName;
+            componentName << name << " component " << i + 1;
+            prcFile->begingroup(componentName.str().c_str());
+            std::vector<uint32_t> tess_indices;
+            writeChunks(prcFile, components[i], input, componentName.str(), materialMathGLid, options, tess_indices);
+            prcFile->endgroup();
+        }
+    }
+    else if (!writeChunks(prcFile, mesh, input, name, materialMathGLid, options, instance.tess_indices) &&
+             options.instances) {
+        state.instances.insert(std::make_pair(hash, instance));
+    }
 
 #else
     const uint32_t nP = (uint32_t)mesh.pointArray.size()/3;
@@ -238,20 +1287,32 @@ BoundingBox addMeshToPrc(String input, oPRCFile* prcFile, float alpha)
     delete [] P;
 #endif
 
-    return mesh.bbox;
+    return bbox;
 }
 
 int main(int argc, char** argv)
 {
     /* check parameters */
     if (argc < 4) {
-        printf ("mshtoprc infile(s) -o outfile.\n");
+        printf ("mshtoprc [-direct] [-weld t] [-strips] [-reorder] [-quantize t] [-bits n] [-instances] [-instancetolerance t] [-materials manifest] [-lod p,...] [-chunk n] [-components n] infile(s) -o outfile.\n");
         return 1;
     }
 
 #ifdef USE_WIDE_CHAR
     std::vector<String> args;
     std::wstring option = L"-o";
+    std::wstring directOption = L"-direct";
+    std::wstring weldOption = L"-weld";
+    std::wstring stripsOption = L"-strips";
+    std::wstring reorderOption = L"-reorder";
+    std::wstring quantizeOption = L"-quantize";
+    std::wstring bitsOption = L"-bits";
+    std::wstring instancesOption = L"-instances";
+    std::wstring instanceToleranceOption = L"-instancetolerance";
+    std::wstring materialsOption = L"-materials";
+    std::wstring lodOption = L"-lod";
+    std::wstring chunkOption = L"-chunk";
+    std::wstring componentsOption = L"-components";
 
     LPWSTR *szArgList;
     int argCount;
@@ -269,11 +1330,127 @@ int main(int argc, char** argv)
 #else
     std::vector<String> args;
     std::string option = "-o";
+    std::string directOption = "-direct";
+    std::string weldOption = "-weld";
+    std::string stripsOption = "-strips";
+    std::string reorderOption = "-reorder";
+    std::string quantizeOption = "-quantize";
+    std::string bitsOption = "-bits";
+    std::string instancesOption = "-instances";
+    std::string instanceToleranceOption = "-instancetolerance";
+    std::string materialsOption = "-materials";
+    std::string lodOption = "-lod";
+    std::string chunkOption = "-chunk";
+    std::string componentsOption = "-components";
 
     for(int i = 1; i < argc; i++)
         args.push_back(std::string(argv[i]));
 #endif
 
+    // -direct writes the meshes without PRC3DTess objects, which is not
+    // yet checked against the output of oPRCFile on real meshes,
+    // -weld welds the points of the meshes,
+    // -strips joins their triangles to strips, -reorder sorts points and
+    // facets for better compression and rendering, -quantize and -bits
+    // round the coordinates to a grid or to fewer significant bits,
+    // -instances writes meshes that are moved copies of others only once,
+    // comparing their points within -instancetolerance,
+    // -materials reads colours for some of the meshes, -lod adds coarser
+    // versions with the given percentages of the facets, -chunk splits
+    // large meshes into parts of at most n facets, -components into their
+    // connected parts, merging those with fewer than n facets
+    Options options;
+    options.direct = false;
+    options.weldTolerance = 0.0;
+    options.strips = false;
+    options.reorder = false;
+    options.grid = 0.0;
+    options.bits = 0;
+    options.instances = false;
+    options.instanceTolerance = 0.0;
+    options.chunkSize = 0;
+    options.componentSize = 0;
+    for (std::size_t i=0; i<args.size(); ) {
+        if (args[i] == directOption) {
+            options.direct = true;
+            args.erase(args.begin() + i);
+            --argc;
+        }
+        else if (args[i] == stripsOption) {
+            options.strips = true;
+            args.erase(args.begin() + i);
+            --argc;
+        }
+        else if (args[i] == reorderOption) {
+            options.reorder = true;
+            args.erase(args.begin() + i);
+            --argc;
+        }
+        else if (args[i] == instancesOption) {
+            options.instances = true;
+            args.erase(args.begin() + i);
+            --argc;
+        }
+        else if (args[i] == weldOption && i+1 < args.size()) {
+            std::basic_istringstream<String::value_type> value(args[i+1]);
+            value >> options.weldTolerance;
+            args.erase(args.begin() + i, args.begin() + i + 2);
+            argc -= 2;
+        }
+        else if (args[i] == quantizeOption && i+1 < args.size()) {
+            std::basic_istringstream<String::value_type> value(args[i+1]);
+            value >> options.grid;
+            args.erase(args.begin() + i, args.begin() + i + 2);
+            argc -= 2;
+        }
+        else if (args[i] == instanceToleranceOption && i+1 < args.size()) {
+            std::basic_istringstream<String::value_type> value(args[i+1]);
+            value >> options.instanceTolerance;
+            args.erase(args.begin() + i, args.begin() + i + 2);
+            argc -= 2;
+        }
+        else if (args[i] == materialsOption && i+1 < args.size()) {
+            if (!readManifest(args[i+1], options.materials))
+                return 1;
+            args.erase(args.begin() + i, args.begin() + i + 2);
+            argc -= 2;
+        }
+        else if (args[i] == lodOption && i+1 < args.size()) {
+            std::basic_istringstream<String::value_type> value(args[i+1]);
+            double percentage;
+            String::value_type separator;
+            while (value >> percentage) {
+                if (percentage > 0.0 && percentage < 100.0)
+                    options.levels.push_back(percentage);
+                value >> separator;
+            }
+            std::sort(options.levels.rbegin(), options.levels.rend());
+            args.erase(args.begin() + i, args.begin() + i + 2);
+            argc -= 2;
+        }
+        else if (args[i] == chunkOption && i+1 < args.size()) {
+            std::basic_istringstream<String::value_type> value(args[i+1]);
+            value >> options.chunkSize;
+            args.erase(args.begin() + i, args.begin() + i + 2);
+            argc -= 2;
+        }
+        else if (args[i] == componentsOption && i+1 < args.size()) {
+            std::basic_istringstream<String::value_type> value(args[i+1]);
+            value >> options.componentSize;
+            args.erase(args.begin() + i, args.begin() + i + 2);
+            argc -= 2;
+        }
+        else if (args[i] == bitsOption && i+1 < args.size()) {
+            std::basic_istringstream<String::value_type> value(args[i+1]);
+            value >> options.bits;
+            args.erase(args.begin() + i, args.begin() + i + 2);
+            argc -= 2;
+        }
+        else {
+            ++i;
+        }
+    }
+
     std::stringstream ostr;
     if (ostr.bad())
         return -1;
@@ -292,6 +1469,7 @@ int main(int argc, char** argv)
     globalbox.maxZ = -FLT_MAX;
     globalbox.minZ =  FLT_MAX;
     float alpha = argc > 4 ? 0.8f : 1.0f;
+    OutputState state;
     for (std::size_t i=0; i<args.size(); i++) {
         String inputFile(args[i]);
         if (inputFile != option) {
@@ -313,7 +1491,7 @@ int main(int argc, char** argv)
                 globalbox.minZ = std::min<float>(globalbox.minZ, 0.0f);
             }
             else {
-                BoundingBox bbox = addMeshToPrc(inputFile, prcFile, alpha);
+                BoundingBox bbox = addMeshToPrc(inputFile, prcFile, alpha, options, state);
                 globalbox.maxX = std::max<float>(globalbox.maxX, bbox.maxX);
                 globalbox.maxY = std::max<float>(globalbox.maxY, bbox.maxY);
                 globalbox.maxZ = std::max<float>(globalbox.maxZ, bbox.maxZ);